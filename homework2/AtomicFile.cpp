@@ -0,0 +1,22 @@
+#include "AtomicFile.hpp"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+bool writeFileAtomically(const std::string& path, const std::vector<unsigned char>& bytes, const std::string& what) {
+    std::string tempName = path + ".tmp";
+    std::ofstream output(tempName, std::ios::binary | std::ios::trunc);
+    output.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    output.close();
+    if (!output) {
+        std::cerr << "Не удалось записать " << what << ": " << tempName << std::endl;
+        return false;
+    }
+    std::error_code ec;
+    std::filesystem::rename(tempName, path, ec);
+    if (ec) {
+        std::cerr << "Не удалось записать " << what << ": " << ec.message() << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,12 @@
+#include <string>
+#include <vector>
+
+#ifndef ATOMICFILE_HPP
+#define ATOMICFILE_HPP
+
+// Запись bytes в path через временный файл и переименование: читатели не
+// увидят файл наполовину записанным. При ошибке в stderr пишется сообщение
+// с описанием what, например "commit-graph"
+bool writeFileAtomically(const std::string& path, const std::vector<unsigned char>& bytes, const std::string& what);
+
+#endif
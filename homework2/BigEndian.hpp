@@ -0,0 +1,24 @@
+#include <arpa/inet.h>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#ifndef BIGENDIAN_HPP
+#define BIGENDIAN_HPP
+
+// Целые в сетевом порядке байт, как их хранят форматы git и PNG
+
+inline uint32_t readBigEndian32(const unsigned char* p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return ntohl(value);
+}
+
+inline void appendBigEndian32(std::vector<unsigned char>& out, uint32_t value) {
+    out.push_back(static_cast<unsigned char>(value >> 24));
+    out.push_back(static_cast<unsigned char>(value >> 16));
+    out.push_back(static_cast<unsigned char>(value >> 8));
+    out.push_back(static_cast<unsigned char>(value));
+}
+
+#endif
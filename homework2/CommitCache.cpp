@@ -0,0 +1,154 @@
+#include "CommitCache.hpp"
+#include "AtomicFile.hpp"
+#include "BigEndian.hpp"
+#include "GitIdxParser.hpp"
+#include "Sha1.hpp"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+const std::string PACK_PREFIX = "commits-";
+const std::string CACHE_EXTENSION = ".cache";
+
+}
+
+CommitCache::CommitCache(const std::string& cacheDir) : cacheDir(cacheDir) {
+    std::error_code ec;
+    std::filesystem::create_directories(cacheDir, ec);
+}
+
+std::string CommitCache::packPath(const unsigned char* packChecksum) const {
+    return (std::filesystem::path(cacheDir) / (PACK_PREFIX + GitIdxParser::bytesToHex(packChecksum, 20) +
+                                               CACHE_EXTENSION)).string();
+}
+
+std::string CommitCache::loosePath() const {
+    return (std::filesystem::path(cacheDir) / ("loose" + CACHE_EXTENSION)).string();
+}
+
+bool CommitCache::readFile(const std::string& path, const unsigned char* key, std::vector<ObjectId>& seen,
+                           std::vector<CommitRecord>& commits) const {
+    std::ifstream input(path, std::ios::binary);
+    if (!input) {
+        return false;
+    }
+    std::vector<unsigned char> file((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+
+    // Недописанный или испорченный файл просто разбирается заново
+    if (file.size() < HEADER_SIZE + 20 || readBigEndian32(file.data()) != CACHE_SIGNATURE ||
+        readBigEndian32(file.data() + 4) != CACHE_VERSION || std::memcmp(file.data() + 8, key, 20) != 0) {
+        return false;
+    }
+    unsigned char checksum[20];
+    Sha1::hash(file.data(), file.size() - 20, checksum);
+    if (std::memcmp(checksum, file.data() + file.size() - 20, 20) != 0) {
+        return false;
+    }
+
+    const unsigned char* p = file.data() + HEADER_SIZE;
+    const unsigned char* end = file.data() + file.size() - 20;
+    uint64_t seenCount = readBigEndian32(file.data() + 28);
+    uint64_t commitCount = readBigEndian32(file.data() + 32);
+    if (static_cast<uint64_t>(end - p) < seenCount * 20) {
+        return false;
+    }
+    seen.resize(seenCount);
+    for (ObjectId& id : seen) {
+        std::memcpy(id.data(), p, 20);
+        p += 20;
+    }
+
+    // Коммит: SHA-1, дата, число родителей и их SHA-1
+    commits.resize(commitCount);
+    for (CommitRecord& record : commits) {
+        if (end - p < 28) {
+            return false;
+        }
+        std::memcpy(record.id, p, 20);
+        record.time = static_cast<int>(readBigEndian32(p + 20));
+        uint64_t parentCount = readBigEndian32(p + 24);
+        p += 28;
+        if (static_cast<uint64_t>(end - p) < parentCount * 20) {
+            return false;
+        }
+        record.parents.resize(parentCount);
+        for (std::string& parent : record.parents) {
+            parent = GitIdxParser::bytesToHex(p, 20);
+            p += 20;
+        }
+    }
+    return p == end;
+}
+
+bool CommitCache::writeFile(const std::string& path, const unsigned char* key, const std::vector<ObjectId>& seen,
+                            const std::vector<CommitRecord>& commits) const {
+    std::vector<unsigned char> file;
+    appendBigEndian32(file, CACHE_SIGNATURE);
+    appendBigEndian32(file, CACHE_VERSION);
+    file.insert(file.end(), key, key + 20);
+    appendBigEndian32(file, static_cast<uint32_t>(seen.size()));
+    appendBigEndian32(file, static_cast<uint32_t>(commits.size()));
+    for (const ObjectId& id : seen) {
+        file.insert(file.end(), id.begin(), id.end());
+    }
+    unsigned char parentId[20];
+    for (const CommitRecord& record : commits) {
+        file.insert(file.end(), record.id, record.id + 20);
+        appendBigEndian32(file, static_cast<uint32_t>(record.time));
+        appendBigEndian32(file, static_cast<uint32_t>(record.parents.size()));
+        for (const std::string& parent : record.parents) {
+            if (!GitIdxParser::hexToBytes(parent, parentId)) {
+                return false;
+            }
+            file.insert(file.end(), parentId, parentId + 20);
+        }
+    }
+    unsigned char checksum[20];
+    Sha1::hash(file.data(), file.size(), checksum);
+    file.insert(file.end(), checksum, checksum + 20);
+
+    return writeFileAtomically(path, file, "кэш коммитов");
+}
+
+bool CommitCache::loadPack(const unsigned char* packChecksum, std::vector<CommitRecord>& commits) const {
+    std::vector<ObjectId> seen;
+    return readFile(packPath(packChecksum), packChecksum, seen, commits);
+}
+
+bool CommitCache::storePack(const unsigned char* packChecksum, const std::vector<CommitRecord>& commits) const {
+    return writeFile(packPath(packChecksum), packChecksum, {}, commits);
+}
+
+void CommitCache::prunePacks(const std::vector<std::string>& livePacks) const {
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(cacheDir, ec)) {
+        std::string name = entry.path().filename().string();
+        if (name.compare(0, PACK_PREFIX.size(), PACK_PREFIX) != 0 || entry.path().extension() != CACHE_EXTENSION) {
+            continue;
+        }
+        std::string checksum = entry.path().stem().string().substr(PACK_PREFIX.size());
+        if (std::find(livePacks.begin(), livePacks.end(), checksum) == livePacks.end()) {
+            std::filesystem::remove(entry.path(), ec);
+        }
+    }
+}
+
+bool CommitCache::loadLoose(std::vector<ObjectId>& seen, std::vector<CommitRecord>& commits) const {
+    const unsigned char key[20] = {};
+    return readFile(loosePath(), key, seen, commits);
+}
+
+bool CommitCache::storeLoose(const std::vector<ObjectId>& seen, const std::vector<CommitRecord>& commits) const {
+    const unsigned char key[20] = {};
+    return writeFile(loosePath(), key, seen, commits);
+}
+
+void CommitCache::dropOlder(std::vector<CommitRecord>& commits, const int& from) {
+    commits.erase(std::remove_if(commits.begin(), commits.end(),
+                                 [&](const CommitRecord& record) { return record.time < from; }),
+                  commits.end());
+}
@@ -0,0 +1,68 @@
+#include <array>
+#include <string>
+#include <vector>
+#include "CommitRecord.hpp"
+
+#ifndef COMMITCACHE_HPP
+#define COMMITCACHE_HPP
+
+// Каталог с коммитами, уже извлечёнными при прошлых запусках. pack файл
+// неизменяем и определяется контрольной суммой из концевика индекса, поэтому
+// его записи хранятся в commits-<сумма>.cache и годятся, пока pack файл жив.
+// Для отдельных объектов запоминается, какие из них уже разобраны: объект
+// тоже неизменяем, его SHA-1 — хэш содержимого. В кэше лежат все коммиты,
+// без отбора по дате, так что граница date от запуска к запуску может меняться.
+class CommitCache {
+public:
+    using ObjectId = std::array<unsigned char, 20>;
+
+    // Сколько pack файлов или отдельных объектов взято из кэша и сколько разобрано заново
+    struct Stats {
+        size_t hits = 0;
+        size_t misses = 0;
+    };
+
+private:
+    static constexpr uint32_t CACHE_SIGNATURE = 0x47565243;  // "GVRC"
+    static constexpr uint32_t CACHE_VERSION = 1;
+    static constexpr size_t HEADER_SIZE = 4 + 4 + 20 + 4 + 4;
+
+    std::string cacheDir;
+
+    std::string packPath(const unsigned char* packChecksum) const;
+
+    std::string loosePath() const;
+
+    // Файл кэша с ключом key; seen — разобранные объекты без коммитов среди них
+    bool readFile(const std::string& path, const unsigned char* key, std::vector<ObjectId>& seen,
+                  std::vector<CommitRecord>& commits) const;
+
+    bool writeFile(const std::string& path, const unsigned char* key, const std::vector<ObjectId>& seen,
+                   const std::vector<CommitRecord>& commits) const;
+
+public:
+    Stats packStats;
+    Stats looseStats;
+
+    // Каталог создаётся, если его ещё нет
+    explicit CommitCache(const std::string& cacheDir);
+
+    // Все коммиты pack файла; false, если записи нет или она испорчена
+    bool loadPack(const unsigned char* packChecksum, std::vector<CommitRecord>& commits) const;
+
+    bool storePack(const unsigned char* packChecksum, const std::vector<CommitRecord>& commits) const;
+
+    // Удаление записей pack файлов, которых нет в livePacks (hex контрольные суммы):
+    // git gc и git repack заменяют pack файлы новыми
+    void prunePacks(const std::vector<std::string>& livePacks) const;
+
+    // Разобранные отдельные объекты, кроме коммитов, и коммиты среди них
+    bool loadLoose(std::vector<ObjectId>& seen, std::vector<CommitRecord>& commits) const;
+
+    bool storeLoose(const std::vector<ObjectId>& seen, const std::vector<CommitRecord>& commits) const;
+
+    // Отбор коммитов не старше from
+    static void dropOlder(std::vector<CommitRecord>& commits, const int& from);
+};
+
+#endif
@@ -0,0 +1,229 @@
+#include "CommitGraph.hpp"
+#include "GitIdxParser.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+bool CommitGraph::load(const std::string& objectsDir) {
+    std::filesystem::path info = std::filesystem::path(objectsDir) / "info";
+    if (std::filesystem::exists(info / "commit-graph")) {
+        return loadFile((info / "commit-graph").string());
+    }
+
+    // Цепочка: хеши файлов слоёв по одному в строке, базовый слой первый
+    std::filesystem::path chainPath = info / "commit-graphs" / "commit-graph-chain";
+    if (!std::filesystem::exists(chainPath)) {
+        return false;
+    }
+    layers.clear();
+    totalCommits = 0;
+
+    std::ifstream chain(chainPath);
+    std::string hash;
+    while (std::getline(chain, hash)) {
+        if (hash.empty()) {
+            continue;
+        }
+        std::filesystem::path layerPath = info / "commit-graphs" / ("graph-" + hash + ".graph");
+        if (!loadLayer(layerPath.string())) {
+            layers.clear();
+            totalCommits = 0;
+            return false;
+        }
+    }
+    return isLoaded();
+}
+
+bool CommitGraph::loadFile(const std::string& filename) {
+    layers.clear();
+    totalCommits = 0;
+    return loadLayer(filename);
+}
+
+bool CommitGraph::loadLayer(const std::string& filename) {
+    Layer layer;
+    try {
+        layer.file = std::make_unique<MappedFile>(filename);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return false;
+    }
+    if (!layer.file->isMapped() || layer.file->size() < GRAPH_HEADER_SIZE + 20) {
+        std::cerr << "Не удалось отобразить commit-graph: " << filename << std::endl;
+        return false;
+    }
+
+    const unsigned char* data = layer.file->data();
+    uint64_t size = layer.file->size();
+
+    // Заголовок: сигнатура, версия, версия хеша, число блоков, число базовых слоёв
+    if (readBigEndian32(data) != GRAPH_SIGNATURE) {
+        std::cerr << "Неверная сигнатура commit-graph" << std::endl;
+        return false;
+    }
+    if (data[4] != 1 || data[5] != 1) {
+        std::cerr << "Неподдерживаемая версия commit-graph" << std::endl;
+        return false;
+    }
+    uint32_t chunkCount = data[6];
+    if (data[7] != layers.size()) {
+        std::cerr << "Слой commit-graph не соответствует цепочке" << std::endl;
+        return false;
+    }
+
+    if (GRAPH_HEADER_SIZE + (chunkCount + 1) * 12 > size) {
+        std::cerr << "commit-graph обрезан" << std::endl;
+        return false;
+    }
+    const unsigned char* fanoutTable = nullptr;
+    uint64_t oidBytes = 0, dataBytes = 0;
+    for (uint32_t i = 0; i < chunkCount; i++) {
+        const unsigned char* entry = data + GRAPH_HEADER_SIZE + i * 12;
+        uint32_t id = readBigEndian32(entry);
+        uint64_t begin = (uint64_t(readBigEndian32(entry + 4)) << 32) | readBigEndian32(entry + 8);
+        uint64_t end = (uint64_t(readBigEndian32(entry + 16)) << 32) | readBigEndian32(entry + 20);
+        if (begin > end || end > size - 20) {
+            std::cerr << "Некорректная таблица блоков commit-graph" << std::endl;
+            return false;
+        }
+
+        if (id == CHUNK_OID_FANOUT && end - begin == 256 * 4) {
+            fanoutTable = data + begin;
+        } else if (id == CHUNK_OID_LOOKUP) {
+            layer.oids = data + begin;
+            oidBytes = end - begin;
+        } else if (id == CHUNK_COMMIT_DATA) {
+            layer.commitData = data + begin;
+            dataBytes = end - begin;
+        } else if (id == CHUNK_EXTRA_EDGES) {
+            layer.extraEdges = data + begin;
+            layer.extraEdgeCount = (end - begin) / 4;
+        }
+    }
+    if (!fanoutTable || !layer.oids || !layer.commitData) {
+        std::cerr << "В commit-graph нет обязательных блоков" << std::endl;
+        return false;
+    }
+
+    for (int i = 0; i < 256; i++) {
+        layer.fanout[i] = readBigEndian32(fanoutTable + i * 4);
+        if (i > 0 && layer.fanout[i] < layer.fanout[i - 1]) {
+            std::cerr << "Fanout таблица commit-graph не монотонна" << std::endl;
+            return false;
+        }
+    }
+    layer.count = layer.fanout[255];
+    if (oidBytes < uint64_t(layer.count) * 20 || dataBytes < uint64_t(layer.count) * COMMIT_DATA_SIZE) {
+        std::cerr << "commit-graph обрезан" << std::endl;
+        return false;
+    }
+
+    layer.firstPosition = totalCommits;
+    totalCommits += layer.count;
+    layers.push_back(std::move(layer));
+    return true;
+}
+
+const CommitGraph::Layer& CommitGraph::layerOf(uint64_t& pos) const {
+    if (pos >= totalCommits) {
+        throw std::runtime_error("Позиция коммита вне commit-graph");
+    }
+    for (size_t i = layers.size(); i-- > 0;) {
+        if (pos >= layers[i].firstPosition) {
+            pos -= layers[i].firstPosition;
+            return layers[i];
+        }
+    }
+    throw std::runtime_error("Позиция коммита вне commit-graph");
+}
+
+const unsigned char* CommitGraph::commitDataAt(uint64_t pos) const {
+    const Layer& layer = layerOf(pos);
+    return layer.commitData + pos * COMMIT_DATA_SIZE;
+}
+
+int64_t CommitGraph::findCommit(const unsigned char* sha1) const {
+    for (const Layer& layer : layers) {
+        uint32_t low = sha1[0] == 0 ? 0 : layer.fanout[sha1[0] - 1];
+        uint32_t high = layer.fanout[sha1[0]];
+        while (low < high) {
+            uint32_t mid = low + (high - low) / 2;
+            int cmp = std::memcmp(layer.oids + uint64_t(mid) * 20, sha1, 20);
+            if (cmp == 0) {
+                return static_cast<int64_t>(layer.firstPosition + mid);
+            }
+            if (cmp < 0) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+    }
+    return -1;
+}
+
+const unsigned char* CommitGraph::sha1At(uint64_t pos) const {
+    const Layer& layer = layerOf(pos);
+    return layer.oids + pos * 20;
+}
+
+uint32_t CommitGraph::generationAt(uint64_t pos) const {
+    // Старшие 30 бит — поколение, младшие 34 — дата
+    return readBigEndian32(commitDataAt(pos) + 28) >> 2;
+}
+
+uint64_t CommitGraph::commitTimeAt(uint64_t pos) const {
+    const unsigned char* data = commitDataAt(pos);
+    return (uint64_t(readBigEndian32(data + 28) & 0x3) << 32) | readBigEndian32(data + 32);
+}
+
+void CommitGraph::parentsAt(uint64_t pos, std::vector<uint64_t>& parents) const {
+    parents.clear();
+    const Layer& layer = layerOf(pos);
+    const unsigned char* data = layer.commitData + pos * COMMIT_DATA_SIZE;
+
+    uint32_t first = readBigEndian32(data + 20);
+    uint32_t second = readBigEndian32(data + 24);
+    if (first == PARENT_NONE) {
+        return;
+    }
+    parents.push_back(first);
+    if (second == PARENT_NONE) {
+        return;
+    }
+    if (!(second & PARENT_EXTRA_EDGES)) {
+        parents.push_back(second);
+        return;
+    }
+
+    // Третий и следующие родители — в блоке EDGE, последний помечен старшим битом
+    for (uint64_t edge = second & ~PARENT_EXTRA_EDGES; ; edge++) {
+        if (edge >= layer.extraEdgeCount) {
+            throw std::runtime_error("Некорректная ссылка на блок EDGE в commit-graph");
+        }
+        uint32_t value = readBigEndian32(layer.extraEdges + edge * 4);
+        parents.push_back(value & ~PARENT_LAST_EDGE);
+        if (value & PARENT_LAST_EDGE) {
+            break;
+        }
+    }
+}
+
+bool CommitGraph::commitRecord(uint64_t pos, const int& from, CommitRecord& record) const {
+    uint64_t time = commitTimeAt(pos);
+    if (time < static_cast<uint64_t>(std::max(from, 0))) {
+        return false;
+    }
+
+    std::memcpy(record.id, sha1At(pos), 20);
+    record.time = static_cast<int>(time);
+    std::vector<uint64_t> parents;
+    parentsAt(pos, parents);
+    record.parents.resize(parents.size());
+    for (size_t k = 0; k < parents.size(); k++) {
+        record.parents[k] = GitIdxParser::bytesToHex(sha1At(parents[k]), 20);
+    }
+    return true;
+}
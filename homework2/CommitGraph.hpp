@@ -0,0 +1,86 @@
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#include <arpa/inet.h>
+#include "BigEndian.hpp"
+#include "CommitRecord.hpp"
+#include "MappedFile.hpp"
+
+#ifndef COMMITGRAPH_HPP
+#define COMMITGRAPH_HPP
+
+// Чтение .git/objects/info/commit-graph и цепочек commit-graphs/commit-graph-chain.
+// В файле уже лежат родители, корневое дерево, номер поколения и дата каждого
+// коммита, поэтому граф строится без распаковки объектов. Файлы отображаются
+// в память; позиция коммита сквозная по всем слоям цепочки, базовый слой первый.
+class CommitGraph {
+private:
+    static constexpr uint32_t GRAPH_SIGNATURE = 0x43475048;  // "CGPH"
+    static constexpr uint64_t GRAPH_HEADER_SIZE = 8;
+    static constexpr uint64_t COMMIT_DATA_SIZE = 20 + 16;
+
+    // Идентификаторы блоков (chunk) файла
+    static constexpr uint32_t CHUNK_OID_FANOUT = 0x4F494446;   // "OIDF"
+    static constexpr uint32_t CHUNK_OID_LOOKUP = 0x4F49444C;   // "OIDL"
+    static constexpr uint32_t CHUNK_COMMIT_DATA = 0x43444154;  // "CDAT"
+    static constexpr uint32_t CHUNK_EXTRA_EDGES = 0x45444745;  // "EDGE"
+
+    static constexpr uint32_t PARENT_NONE = 0x70000000;
+    static constexpr uint32_t PARENT_EXTRA_EDGES = 0x80000000;
+    static constexpr uint32_t PARENT_LAST_EDGE = 0x80000000;
+
+    struct Layer {
+        std::unique_ptr<MappedFile> file;
+        uint32_t fanout[256] = {};
+        uint32_t count = 0;
+        uint64_t firstPosition = 0;
+        const unsigned char* oids = nullptr;
+        const unsigned char* commitData = nullptr;
+        const unsigned char* extraEdges = nullptr;
+        uint64_t extraEdgeCount = 0;
+    };
+
+    std::vector<Layer> layers;
+    uint64_t totalCommits = 0;
+
+    bool loadLayer(const std::string& filename);
+
+    // Слой, в котором лежит позиция; pos становится номером внутри слоя
+    const Layer& layerOf(uint64_t& pos) const;
+
+    const unsigned char* commitDataAt(uint64_t pos) const;
+
+public:
+    // objectsDir — каталог .git/objects. false, если графа нет или он испорчен
+    bool load(const std::string& objectsDir);
+
+    // Один файл commit-graph без цепочки
+    bool loadFile(const std::string& filename);
+
+    bool isLoaded() const { return !layers.empty(); }
+
+    size_t layerCount() const { return layers.size(); }
+
+    uint64_t commitCount() const { return totalCommits; }
+
+    // Позиция коммита или -1, если граф его не покрывает
+    int64_t findCommit(const unsigned char* sha1) const;
+
+    const unsigned char* sha1At(uint64_t pos) const;
+
+    const unsigned char* treeAt(uint64_t pos) const { return commitDataAt(pos); }
+
+    uint32_t generationAt(uint64_t pos) const;
+
+    // Дата коммитера, секунды unix time
+    uint64_t commitTimeAt(uint64_t pos) const;
+
+    // Позиции всех родителей в порядке из коммита
+    void parentsAt(uint64_t pos, std::vector<uint64_t>& parents) const;
+
+    // Запись для графа зависимостей; false, если коммит старше from
+    bool commitRecord(uint64_t pos, const int& from, CommitRecord& record) const;
+};
+
+#endif
@@ -0,0 +1,252 @@
+#include "CommitGraphWriter.hpp"
+#include "AtomicFile.hpp"
+#include "BigEndian.hpp"
+#include "CommitHeader.hpp"
+#include "GitIdxParser.hpp"
+#include "GitPackParser.hpp"
+#include "ParallelFor.hpp"
+#include "Sha1.hpp"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+bool CommitGraphWriter::parseCommit(const std::vector<uint8_t>& content, Commit& commit) {
+    CommitHeader header;
+    if (!CommitHeader::parse(std::string_view(reinterpret_cast<const char*>(content.data()), content.size()), header) ||
+        !GitIdxParser::hexToBytes(header.tree, commit.tree.data())) {
+        return false;
+    }
+
+    commit.parents.resize(header.parentCount());
+    for (size_t k = 0; k < header.parentCount(); k++) {
+        if (!GitIdxParser::hexToBytes(header.parent(k), commit.parents[k].data())) {
+            return false;
+        }
+    }
+    commit.time = header.committer.time < 0 ? 0 : static_cast<uint64_t>(header.committer.time);
+    return true;
+}
+
+void CommitGraphWriter::addPacks(const PackSet& packs, unsigned threads) {
+    threads = resolveThreadCount(threads);
+    for (size_t p = 0; p < packs.packCount(); p++) {
+        const GitIdxParser* index = packs.packIndex(p);
+        const GitPackParser* parser = packs.packParser(p);
+        if (!index || !parser) {
+            continue;
+        }
+
+        std::vector<std::vector<Commit>> found(threads);
+        std::vector<size_t> failed(threads, 0);
+        parallelFor(index->objectCount(), threads, DECODE_GRAIN, [&](unsigned worker, size_t begin, size_t end) {
+            Commit commit;
+            std::vector<uint8_t> content;
+            for (size_t i = begin; i < end; i++) {
+                try {
+                    uint64_t offset = index->offsetAt(i);
+                    if (parser->peekType(offset) != GitObjectType::COMMIT) {
+                        continue;
+                    }
+                    parser->getObjectContent(offset, content);
+                    if (!parseCommit(content, commit)) {
+                        failed[worker]++;
+                        continue;
+                    }
+                    std::memcpy(commit.id.data(), index->sha1At(i), 20);
+                    found[worker].push_back(commit);
+                } catch (const std::exception& e) {
+                    failed[worker]++;
+                }
+            }
+        });
+        for (std::vector<Commit>& part : found) {
+            commits.insert(commits.end(), std::make_move_iterator(part.begin()), std::make_move_iterator(part.end()));
+        }
+        for (size_t count : failed) {
+            failures += count;
+        }
+    }
+}
+
+bool CommitGraphWriter::write(const std::string& filename) {
+    std::sort(commits.begin(), commits.end(), [](const Commit& a, const Commit& b) { return a.id < b.id; });
+    commits.erase(std::unique(commits.begin(), commits.end(), [](const Commit& a, const Commit& b) {
+        return a.id == b.id;
+    }), commits.end());
+
+    auto positionOf = [&](const ObjectId& id) -> int64_t {
+        auto it = std::lower_bound(commits.begin(), commits.end(), id, [](const Commit& c, const ObjectId& v) {
+            return c.id < v;
+        });
+        return it != commits.end() && it->id == id ? it - commits.begin() : -1;
+    };
+
+    // Граф должен быть замкнут по родителям: коммит без родителя в наборе
+    // (например, из неглубокого клона) исключается вместе со всеми потомками
+    size_t count = commits.size();
+    std::vector<std::vector<int64_t>> parentIndex(count);
+    std::vector<std::vector<size_t>> children(count);
+    std::vector<bool> excluded(count, false);
+    std::vector<size_t> pending;
+    for (size_t i = 0; i < count; i++) {
+        for (const ObjectId& parent : commits[i].parents) {
+            int64_t pos = positionOf(parent);
+            parentIndex[i].push_back(pos);
+            if (pos < 0) {
+                if (!excluded[i]) {
+                    excluded[i] = true;
+                    pending.push_back(i);
+                }
+            } else {
+                children[pos].push_back(i);
+            }
+        }
+    }
+    while (!pending.empty()) {
+        size_t i = pending.back();
+        pending.pop_back();
+        for (size_t child : children[i]) {
+            if (!excluded[child]) {
+                excluded[child] = true;
+                pending.push_back(child);
+            }
+        }
+    }
+
+    std::vector<uint32_t> newPosition(count, 0);
+    uint32_t kept = 0;
+    for (size_t i = 0; i < count; i++) {
+        newPosition[i] = kept;
+        kept += excluded[i] ? 0 : 1;
+    }
+
+    // Поколение: 1 для корня, иначе на единицу больше максимума по родителям
+    std::vector<uint32_t> generation(count, 0);
+    std::vector<std::pair<size_t, size_t>> stack;
+    for (size_t start = 0; start < count; start++) {
+        if (excluded[start] || generation[start]) {
+            continue;
+        }
+        stack.push_back({start, 0});
+        while (!stack.empty()) {
+            auto& [i, next] = stack.back();
+            if (next < parentIndex[i].size()) {
+                size_t parent = static_cast<size_t>(parentIndex[i][next++]);
+                if (!generation[parent]) {
+                    stack.push_back({parent, 0});
+                }
+                continue;
+            }
+            uint32_t value = 1;
+            for (int64_t parent : parentIndex[i]) {
+                value = std::max(value, std::min(generation[parent] + 1, GENERATION_MAX));
+            }
+            generation[i] = value;
+            stack.pop_back();
+        }
+    }
+
+    // Блоки файла
+    std::vector<unsigned char> fanout, lookup, data, edges;
+    uint32_t counts[256] = {};
+    for (size_t i = 0; i < count; i++) {
+        if (excluded[i]) {
+            continue;
+        }
+        const Commit& commit = commits[i];
+        counts[commit.id[0]]++;
+        lookup.insert(lookup.end(), commit.id.begin(), commit.id.end());
+
+        data.insert(data.end(), commit.tree.begin(), commit.tree.end());
+        const std::vector<int64_t>& parents = parentIndex[i];
+        appendBigEndian32(data, parents.empty() ? PARENT_NONE : newPosition[parents[0]]);
+        if (parents.size() <= 1) {
+            appendBigEndian32(data, PARENT_NONE);
+        } else if (parents.size() == 2) {
+            appendBigEndian32(data, newPosition[parents[1]]);
+        } else {
+            appendBigEndian32(data, PARENT_EXTRA_EDGES | static_cast<uint32_t>(edges.size() / 4));
+            for (size_t k = 1; k < parents.size(); k++) {
+                uint32_t value = newPosition[parents[k]];
+                appendBigEndian32(edges, k + 1 == parents.size() ? value | PARENT_EXTRA_EDGES : value);
+            }
+        }
+        // Старшие 30 бит — поколение, младшие 34 — дата коммитера
+        uint64_t time = std::min<uint64_t>(commit.time, (uint64_t(1) << 34) - 1);
+        appendBigEndian32(data, (generation[i] << 2) | static_cast<uint32_t>(time >> 32));
+        appendBigEndian32(data, static_cast<uint32_t>(time));
+    }
+    uint32_t total = 0;
+    for (int b = 0; b < 256; b++) {
+        total += counts[b];
+        appendBigEndian32(fanout, total);
+    }
+
+    std::vector<std::pair<uint32_t, const std::vector<unsigned char>*>> chunks = {
+        {CHUNK_OID_FANOUT, &fanout}, {CHUNK_OID_LOOKUP, &lookup}, {CHUNK_COMMIT_DATA, &data}};
+    if (!edges.empty()) {
+        chunks.push_back({CHUNK_EXTRA_EDGES, &edges});
+    }
+
+    std::vector<unsigned char> file;
+    appendBigEndian32(file, GRAPH_SIGNATURE);
+    file.push_back(1);  // версия
+    file.push_back(1);  // SHA-1
+    file.push_back(static_cast<unsigned char>(chunks.size()));
+    file.push_back(0);  // базовых слоёв нет
+
+    uint64_t offset = 8 + (chunks.size() + 1) * 12;
+    for (size_t k = 0; k <= chunks.size(); k++) {
+        appendBigEndian32(file, k < chunks.size() ? chunks[k].first : 0);
+        appendBigEndian32(file, static_cast<uint32_t>(offset >> 32));
+        appendBigEndian32(file, static_cast<uint32_t>(offset));
+        if (k < chunks.size()) {
+            offset += chunks[k].second->size();
+        }
+    }
+    for (const auto& chunk : chunks) {
+        file.insert(file.end(), chunk.second->begin(), chunk.second->end());
+    }
+    unsigned char checksum[20];
+    Sha1::hash(file.data(), file.size(), checksum);
+    file.insert(file.end(), checksum, checksum + 20);
+
+    return writeFileAtomically(filename, file, "commit-graph");
+}
+
+bool CommitGraphWriter::loadCached(const PackSet& packs, const std::string& cacheDir, CommitGraph& graph,
+                                   unsigned threads) {
+    if (packs.packCount() == 0) {
+        return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(cacheDir, ec);
+    const std::string prefix = "commit-graph-";
+    std::string name = prefix + packs.fingerprint() + ".graph";
+    std::filesystem::path path = std::filesystem::path(cacheDir) / name;
+    if (std::filesystem::exists(path) && graph.loadFile(path.string())) {
+        return true;
+    }
+
+    CommitGraphWriter writer;
+    writer.addPacks(packs, threads);
+    if (writer.decodeFailures()) {
+        std::cerr << "commit-graph не построен: не прочитано объектов " << writer.decodeFailures() << std::endl;
+        return false;
+    }
+    if (!writer.write(path.string())) {
+        return false;
+    }
+
+    // Графы для прежних наборов pack файлов больше не понадобятся
+    for (const auto& entry : std::filesystem::directory_iterator(cacheDir, ec)) {
+        std::string other = entry.path().filename().string();
+        if (other != name && other.compare(0, prefix.size(), prefix) == 0 && entry.path().extension() == ".graph") {
+            std::filesystem::remove(entry.path(), ec);
+        }
+    }
+    return graph.loadFile(path.string());
+}
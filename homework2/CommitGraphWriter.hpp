@@ -0,0 +1,68 @@
+#include <array>
+#include <string>
+#include <vector>
+#include "CommitGraph.hpp"
+#include "PackSet.hpp"
+
+#ifndef COMMITGRAPHWRITER_HPP
+#define COMMITGRAPHWRITER_HPP
+
+// Запись файла commit-graph по коммитам, распакованным из pack файлов.
+// Формат тот же, что у git: блоки OIDF, OIDL, CDAT и, для коммитов с тремя
+// и более родителями, EDGE; поколения считаются при записи.
+class CommitGraphWriter {
+public:
+    using ObjectId = std::array<unsigned char, 20>;
+
+    struct Commit {
+        ObjectId id;
+        ObjectId tree;
+        std::vector<ObjectId> parents;
+        uint64_t time = 0;
+    };
+
+private:
+    static constexpr uint32_t GRAPH_SIGNATURE = 0x43475048;  // "CGPH"
+    static constexpr uint32_t CHUNK_OID_FANOUT = 0x4F494446;
+    static constexpr uint32_t CHUNK_OID_LOOKUP = 0x4F49444C;
+    static constexpr uint32_t CHUNK_COMMIT_DATA = 0x43444154;
+    static constexpr uint32_t CHUNK_EXTRA_EDGES = 0x45444745;
+    static constexpr uint32_t PARENT_NONE = 0x70000000;
+    static constexpr uint32_t PARENT_EXTRA_EDGES = 0x80000000;
+    static constexpr uint32_t GENERATION_MAX = 0x3FFFFFFF;
+    // Коммитов в одной порции параллельной распаковки
+    static constexpr size_t DECODE_GRAIN = 256;
+
+    std::vector<Commit> commits;
+    // Объектов pack файлов, которые не удалось прочитать или разобрать как коммит
+    size_t failures = 0;
+
+public:
+    // Дерево, родители и дата коммитера из заголовка коммита
+    static bool parseCommit(const std::vector<uint8_t>& content, Commit& commit);
+
+    void add(Commit commit) { commits.push_back(std::move(commit)); }
+
+    // Все коммиты из pack файлов набора: перебор записей индексов и распаковка
+    // через GitPackParser на threads потоках. Объекты, которые не прочитались,
+    // считаются в decodeFailures
+    void addPacks(const PackSet& packs, unsigned threads = 1);
+
+    size_t commitCount() const { return commits.size(); }
+
+    // Без потерянных коммитов граф полон; иначе их потомки выпали бы из него
+    size_t decodeFailures() const { return failures; }
+
+    // Запись во временный файл и переименование; коммиты, у которых нет
+    // в наборе хотя бы одного предка, в граф не попадают
+    bool write(const std::string& filename);
+
+    // commit-graph для pack файлов набора из каталога кэша. Если файла для
+    // текущего отпечатка PackSet нет, он строится и записывается, а файлы
+    // для прежних наборов pack файлов удаляются. Граф, при построении которого
+    // часть объектов не прочиталась, не сохраняется и не используется
+    static bool loadCached(const PackSet& packs, const std::string& cacheDir, CommitGraph& graph,
+                           unsigned threads = 1);
+};
+
+#endif
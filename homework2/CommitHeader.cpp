@@ -0,0 +1,101 @@
+#include "CommitHeader.hpp"
+
+static bool isHex(std::string_view value) {
+    for (char c : value) {
+        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CommitHeader::parseSignature(std::string_view value, CommitSignature& signature) {
+    // С конца: часовой пояс, затем дата; всё до них — имя и почта
+    size_t zoneStart = value.rfind(' ');
+    if (zoneStart == std::string_view::npos || zoneStart == 0) {
+        return false;
+    }
+    size_t timeStart = value.rfind(' ', zoneStart - 1);
+    if (timeStart == std::string_view::npos) {
+        return false;
+    }
+
+    std::string_view time = value.substr(timeStart + 1, zoneStart - timeStart - 1);
+    std::string_view zone = value.substr(zoneStart + 1);
+    if (time.empty() || zone.size() != 5 || (zone[0] != '+' && zone[0] != '-')) {
+        return false;
+    }
+
+    signature.time = 0;
+    for (char c : time) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        signature.time = signature.time * 10 + (c - '0');
+    }
+    for (size_t i = 1; i < 5; i++) {
+        if (zone[i] < '0' || zone[i] > '9') {
+            return false;
+        }
+    }
+    int minutes = ((zone[1] - '0') * 10 + (zone[2] - '0')) * 60 + (zone[3] - '0') * 10 + (zone[4] - '0');
+    signature.timezone = zone[0] == '-' ? -minutes : minutes;
+    signature.identity = value.substr(0, timeStart);
+    return true;
+}
+
+bool CommitHeader::parse(std::string_view text, CommitHeader& header) {
+    header = CommitHeader();
+    bool hasCommitter = false;
+    size_t parentBegin = std::string_view::npos, parentEnd = 0;
+    size_t pos = 0;
+
+    // Заголовок заканчивается пустой строкой, дальше — сообщение коммита
+    while (pos < text.size() && text[pos] != '\n') {
+        size_t lineEnd = text.find('\n', pos);
+        if (lineEnd == std::string_view::npos) {
+            lineEnd = text.size();
+        }
+        std::string_view line = text.substr(pos, lineEnd - pos);
+
+        if (line.size() == 45 && line.compare(0, 5, "tree ") == 0 && pos == 0) {
+            header.tree = line.substr(5);
+            if (!isHex(header.tree)) {
+                return false;
+            }
+        } else if (line.compare(0, 7, "parent ") == 0) {
+            if (line.size() != 47 || !isHex(line.substr(7)) || lineEnd == text.size()) {
+                return false;
+            }
+            if (parentBegin == std::string_view::npos) {
+                parentBegin = pos;
+            } else if (parentEnd != pos) {
+                return false;
+            }
+            parentEnd = lineEnd + 1;
+        } else if (line.compare(0, 7, "author ") == 0) {
+            if (!parseSignature(line.substr(7), header.author)) {
+                return false;
+            }
+        } else if (line.compare(0, 10, "committer ") == 0) {
+            if (!parseSignature(line.substr(10), header.committer)) {
+                return false;
+            }
+            hasCommitter = true;
+        }
+        // Остальные строки (encoding, gpgsig с продолжениями, mergetag) пропускаем
+        pos = lineEnd + 1;
+    }
+
+    if (header.tree.empty() || !hasCommitter) {
+        return false;
+    }
+    if (parentBegin != std::string_view::npos) {
+        if (parentBegin != 46) {
+            return false;
+        }
+        header.parentLines = text.substr(parentBegin, parentEnd - parentBegin);
+    }
+    header.message = pos < text.size() ? text.substr(pos + 1) : std::string_view();
+    return true;
+}
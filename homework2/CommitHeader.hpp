@@ -0,0 +1,42 @@
+#include <cstdint>
+#include <string_view>
+
+#ifndef COMMITHEADER_HPP
+#define COMMITHEADER_HPP
+
+// Подпись author/committer: "Имя <почта> 1700000000 +0300"
+struct CommitSignature {
+    std::string_view identity;  // "Имя <почта>"
+    int64_t time = 0;           // секунды unix time
+    int timezone = 0;           // смещение от UTC в минутах, +0300 -> 180
+};
+
+// Разбор заголовка коммита без копирования: все поля — окна в исходный текст,
+// поэтому текст должен жить дольше объекта. Память не выделяется.
+class CommitHeader {
+public:
+    std::string_view tree;  // 40 hex-символов
+    CommitSignature author;
+    CommitSignature committer;
+    std::string_view message;
+
+    size_t parentCount() const { return parentLines.size() / PARENT_LINE_SIZE; }
+
+    // k-й родитель, 40 hex-символов; порядок как в коммите
+    std::string_view parent(size_t k) const { return parentLines.substr(k * PARENT_LINE_SIZE + 7, 40); }
+
+    // false, если это не заголовок коммита: нет tree, committer или строки parent
+    // идут не подряд сразу за tree
+    static bool parse(std::string_view text, CommitHeader& header);
+
+private:
+    // "parent " + 40 hex-символов + '\n'
+    static constexpr size_t PARENT_LINE_SIZE = 48;
+
+    // Строки parent лежат в коммите подряд, поэтому хватает одного окна на все
+    std::string_view parentLines;
+
+    static bool parseSignature(std::string_view value, CommitSignature& signature);
+};
+
+#endif
@@ -0,0 +1,17 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#ifndef COMMITRECORD_HPP
+#define COMMITRECORD_HPP
+
+// Коммит, попадающий в диаграмму
+class CommitRecord {
+public:
+    unsigned char id[20];
+    int time;
+    // Все родители в порядке из коммита, hex; у корневого коммита пусто
+    std::vector<std::string> parents;
+};
+
+#endif
@@ -0,0 +1,240 @@
+#include "Decompressor.hpp"
+#include <algorithm>
+#include <climits>
+#include <stdexcept>
+#include <zlib.h>
+#ifdef GRAPHVIZ_WITH_LIBDEFLATE
+#include <libdeflate.h>
+#endif
+
+namespace {
+
+// Обычный zlib: один z_stream, между объектами только inflateReset
+class ZlibDecompressor : public Decompressor {
+private:
+    z_stream zs = {};
+    // Остаток текущей порции входа, ещё не переданный zlib
+    const uint8_t* chunk = nullptr;
+    size_t chunkLeft = 0;
+
+    void reset() {
+        inflateReset(&zs);
+        zs.avail_in = 0;
+        zs.avail_out = 0;
+        chunkLeft = 0;
+    }
+
+    // Следующее окно входа; avail_in 32-битный, поэтому большие порции
+    // подаются частями. false, если источник исчерпан
+    bool feed(const InputSource& input) {
+        if (chunkLeft == 0 && (chunkLeft = input(chunk)) == 0) {
+            return false;
+        }
+        zs.next_in = const_cast<Bytef*>(chunk);
+        zs.avail_in = static_cast<uInt>(std::min<size_t>(chunkLeft, UINT_MAX));
+        chunk += zs.avail_in;
+        chunkLeft -= zs.avail_in;
+        return true;
+    }
+
+    // Ровно outputSize байт из остатка порции и следующих порций input
+    void run(const InputSource& input, uint8_t* output, size_t outputSize) {
+        size_t outputLeft = outputSize;
+        uint8_t overflow;
+
+        int ret = Z_OK;
+        while (ret != Z_STREAM_END) {
+            if (zs.avail_in == 0 && !feed(input)) {
+                throw std::runtime_error("Сжатые данные выходят за границу объекта");
+            }
+            // avail_out тоже 32-битный: большие объекты выдаются окнами.
+            // Если буфер заполнен, а поток не закончен, данных больше заявленного
+            if (zs.avail_out == 0) {
+                if (outputLeft > 0) {
+                    zs.next_out = output + (outputSize - outputLeft);
+                    zs.avail_out = static_cast<uInt>(std::min<size_t>(outputLeft, UINT_MAX));
+                    outputLeft -= zs.avail_out;
+                } else {
+                    zs.next_out = &overflow;
+                    zs.avail_out = 1;
+                }
+            }
+            ret = ::inflate(&zs, Z_NO_FLUSH);
+            if (ret != Z_OK && ret != Z_STREAM_END && !(ret == Z_BUF_ERROR && zs.avail_in == 0)) {
+                throw std::runtime_error("Ошибка декомпрессии");
+            }
+            if (zs.total_out > outputSize) {
+                throw std::runtime_error("Размер распакованного объекта больше заявленного");
+            }
+        }
+        if (zs.total_out != outputSize) {
+            throw std::runtime_error("Размер распакованного объекта меньше заявленного");
+        }
+    }
+
+public:
+    ZlibDecompressor() {
+        if (inflateInit(&zs) != Z_OK) {
+            throw std::runtime_error("Ошибка инициализации zlib");
+        }
+    }
+
+    ~ZlibDecompressor() override { inflateEnd(&zs); }
+
+    Backend backend() const override { return Backend::ZLIB; }
+
+    void inflate(const uint8_t* input, size_t inputSize, uint8_t* output, size_t outputSize) override {
+        // Границы известны: весь вход сразу лежит в остатке порции
+        reset();
+        chunk = input;
+        chunkLeft = inputSize;
+        run([](const uint8_t*&) -> size_t { return 0; }, output, outputSize);
+    }
+
+    void inflate(const InputSource& input, uint8_t* output, size_t outputSize) override {
+        reset();
+        run(input, output, outputSize);
+    }
+
+    size_t inflatePrefix(const InputSource& input, uint8_t* output, size_t maxBytes) override {
+        reset();
+        size_t wanted = std::min<size_t>(maxBytes, UINT_MAX);
+        zs.next_out = output;
+        zs.avail_out = static_cast<uInt>(wanted);
+
+        int ret = Z_OK;
+        while (zs.avail_out > 0 && ret != Z_STREAM_END) {
+            if (zs.avail_in == 0 && !feed(input)) {
+                break;
+            }
+            ret = ::inflate(&zs, Z_SYNC_FLUSH);
+            if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
+                throw std::runtime_error("Ошибка декомпрессии");
+            }
+        }
+        return wanted - zs.avail_out;
+    }
+};
+
+#ifdef GRAPHVIZ_WITH_LIBDEFLATE
+// libdeflate распаковывает буфер целиком за один вызов, без потокового
+// состояния; ему и нужны точные границы сжатых данных
+class LibdeflateDecompressor : public Decompressor {
+private:
+    libdeflate_decompressor* decompressor = nullptr;
+
+public:
+    LibdeflateDecompressor() : decompressor(libdeflate_alloc_decompressor()) {
+        if (!decompressor) {
+            throw std::runtime_error("Ошибка инициализации libdeflate");
+        }
+    }
+
+    ~LibdeflateDecompressor() override { libdeflate_free_decompressor(decompressor); }
+
+    Backend backend() const override { return Backend::LIBDEFLATE; }
+
+    void inflate(const uint8_t* input, size_t inputSize, uint8_t* output, size_t outputSize) override {
+        size_t produced = 0;
+        libdeflate_result result =
+            libdeflate_zlib_decompress(decompressor, input, inputSize, output, outputSize, &produced);
+        if (result == LIBDEFLATE_INSUFFICIENT_SPACE) {
+            throw std::runtime_error("Размер распакованного объекта больше заявленного");
+        }
+        if (result != LIBDEFLATE_SUCCESS) {
+            throw std::runtime_error("Ошибка декомпрессии");
+        }
+        if (produced != outputSize) {
+            throw std::runtime_error("Размер распакованного объекта меньше заявленного");
+        }
+    }
+};
+#endif
+
+}
+
+void Decompressor::inflate(const InputSource&, uint8_t*, size_t) {
+    throw std::runtime_error("Распаковщику " + backendName(backend()) + " нужны границы сжатых данных");
+}
+
+size_t Decompressor::inflatePrefix(const InputSource&, uint8_t*, size_t) {
+    throw std::runtime_error("Распаковщику " + backendName(backend()) + " нужны границы сжатых данных");
+}
+
+std::unique_ptr<Decompressor> Decompressor::create(Backend backend) {
+    switch (backend) {
+        case Backend::ZLIB:
+            return std::make_unique<ZlibDecompressor>();
+#ifdef GRAPHVIZ_WITH_ZLIB_NG
+        case Backend::ZLIB_NG:
+            return createZlibNg();
+#endif
+#ifdef GRAPHVIZ_WITH_LIBDEFLATE
+        case Backend::LIBDEFLATE:
+            return std::make_unique<LibdeflateDecompressor>();
+#endif
+        default:
+            return nullptr;
+    }
+}
+
+Decompressor& Decompressor::forThread(Backend backend) {
+    thread_local std::unique_ptr<Decompressor> decompressors[3];
+    std::unique_ptr<Decompressor>& decompressor = decompressors[static_cast<int>(backend)];
+    if (!decompressor) {
+        decompressor = create(backend);
+        if (!decompressor) {
+            throw std::runtime_error("Распаковщик " + backendName(backend) + " не подключён при сборке");
+        }
+    }
+    return *decompressor;
+}
+
+bool Decompressor::isAvailable(Backend backend) {
+    switch (backend) {
+        case Backend::ZLIB:
+            return true;
+        case Backend::ZLIB_NG:
+#ifdef GRAPHVIZ_WITH_ZLIB_NG
+            return true;
+#else
+            return false;
+#endif
+        case Backend::LIBDEFLATE:
+#ifdef GRAPHVIZ_WITH_LIBDEFLATE
+            return true;
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+std::vector<Decompressor::Backend> Decompressor::availableBackends() {
+    std::vector<Backend> backends;
+    for (Backend backend : {Backend::ZLIB, Backend::ZLIB_NG, Backend::LIBDEFLATE}) {
+        if (isAvailable(backend)) {
+            backends.push_back(backend);
+        }
+    }
+    return backends;
+}
+
+std::string Decompressor::backendName(Backend backend) {
+    switch (backend) {
+        case Backend::ZLIB: return "zlib";
+        case Backend::ZLIB_NG: return "zlib-ng";
+        case Backend::LIBDEFLATE: return "libdeflate";
+    }
+    return "unknown";
+}
+
+bool Decompressor::parseBackend(const std::string& name, Backend& backend) {
+    for (Backend candidate : {Backend::ZLIB, Backend::ZLIB_NG, Backend::LIBDEFLATE}) {
+        if (name == backendName(candidate)) {
+            backend = candidate;
+            return true;
+        }
+    }
+    return false;
+}
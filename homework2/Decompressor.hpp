@@ -0,0 +1,62 @@
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifndef DECOMPRESSOR_HPP
+#define DECOMPRESSOR_HPP
+
+// Распаковка zlib потока объекта. Обычный zlib есть всегда и умеет читать
+// поток по частям, когда граница сжатых данных неизвестна; zlib-ng и libdeflate
+// подключаются при сборке флагами GRAPHVIZ_WITH_ZLIB_NG и GRAPHVIZ_WITH_LIBDEFLATE
+// и требуют точных границ.
+// Объект хранит состояние распаковщика и не потокобезопасен: у каждого потока свой.
+class Decompressor {
+private:
+    static std::unique_ptr<Decompressor> createZlibNg();
+
+public:
+    enum class Backend {
+        ZLIB,
+        ZLIB_NG,
+        LIBDEFLATE
+    };
+
+    // Следующая порция сжатых данных: указатель в data и длина; 0 — данных больше нет
+    using InputSource = std::function<size_t(const uint8_t*& data)>;
+
+    virtual ~Decompressor() = default;
+
+    virtual Backend backend() const = 0;
+
+    // Распаковка всего потока input ровно в outputSize байт output; при
+    // испорченном потоке или другом размере результата — runtime_error
+    virtual void inflate(const uint8_t* input, size_t inputSize, uint8_t* output, size_t outputSize) = 0;
+
+    // То же, но вход подаётся порциями, пока поток не закончится. Только для zlib,
+    // у остальных — runtime_error
+    virtual void inflate(const InputSource& input, uint8_t* output, size_t outputSize);
+
+    // Первые байты потока, не больше maxBytes: распаковка останавливается, как
+    // только они получены. Возвращает их число. Только для zlib
+    virtual size_t inflatePrefix(const InputSource& input, uint8_t* output, size_t maxBytes);
+
+    // nullptr, если библиотека не подключена при сборке
+    static std::unique_ptr<Decompressor> create(Backend backend);
+
+    // Распаковщик backend для текущего потока, создаётся при первом обращении
+    static Decompressor& forThread(Backend backend);
+
+    static bool isAvailable(Backend backend);
+
+    // Подключённые при сборке библиотеки
+    static std::vector<Backend> availableBackends();
+
+    static std::string backendName(Backend backend);
+
+    // "zlib", "zlib-ng" или "libdeflate"; false для неизвестного имени
+    static bool parseBackend(const std::string& name, Backend& backend);
+};
+
+#endif
@@ -0,0 +1,76 @@
+#include "Decompressor.hpp"
+
+// zlib-ng в собственном режиме нельзя подключать в одной единице трансляции
+// с zlib.h, поэтому он собран отдельно
+#ifdef GRAPHVIZ_WITH_ZLIB_NG
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <zlib-ng.h>
+
+namespace {
+
+// Тот же протокол потока, что у zlib, но функции и типы с префиксом zng_
+class ZlibNgDecompressor : public Decompressor {
+private:
+    zng_stream zs = {};
+
+public:
+    ZlibNgDecompressor() {
+        if (zng_inflateInit(&zs) != Z_OK) {
+            throw std::runtime_error("Ошибка инициализации zlib-ng");
+        }
+    }
+
+    ~ZlibNgDecompressor() override { zng_inflateEnd(&zs); }
+
+    Backend backend() const override { return Backend::ZLIB_NG; }
+
+    void inflate(const uint8_t* input, size_t inputSize, uint8_t* output, size_t outputSize) override {
+        zng_inflateReset(&zs);
+        zs.next_in = input;
+        zs.avail_in = static_cast<uint32_t>(std::min<size_t>(inputSize, UINT32_MAX));
+        size_t inputLeft = inputSize - zs.avail_in;
+        zs.next_out = output;
+        zs.avail_out = static_cast<uint32_t>(std::min<size_t>(outputSize, UINT32_MAX));
+        size_t outputLeft = outputSize - zs.avail_out;
+        uint8_t overflow;
+
+        int ret = Z_OK;
+        while (ret != Z_STREAM_END) {
+            if (zs.avail_in == 0 && inputLeft > 0) {
+                zs.avail_in = static_cast<uint32_t>(std::min<size_t>(inputLeft, UINT32_MAX));
+                inputLeft -= zs.avail_in;
+            }
+            if (zs.avail_out == 0) {
+                if (outputLeft > 0) {
+                    zs.avail_out = static_cast<uint32_t>(std::min<size_t>(outputLeft, UINT32_MAX));
+                    outputLeft -= zs.avail_out;
+                } else {
+                    zs.next_out = &overflow;
+                    zs.avail_out = 1;
+                }
+            }
+            ret = zng_inflate(&zs, Z_NO_FLUSH);
+            if (ret == Z_BUF_ERROR && zs.avail_in == 0 && inputLeft == 0) {
+                throw std::runtime_error("Сжатые данные выходят за границу объекта");
+            }
+            if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
+                throw std::runtime_error("Ошибка декомпрессии");
+            }
+            if (zs.total_out > outputSize) {
+                throw std::runtime_error("Размер распакованного объекта больше заявленного");
+            }
+        }
+        if (zs.total_out != outputSize) {
+            throw std::runtime_error("Размер распакованного объекта меньше заявленного");
+        }
+    }
+};
+
+}
+
+std::unique_ptr<Decompressor> Decompressor::createZlibNg() {
+    return std::make_unique<ZlibNgDecompressor>();
+}
+#endif
@@ -0,0 +1,248 @@
+#include "Delta.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+// Наибольшая длина одной команды копирования
+constexpr uint64_t MAX_OP_SIZE = 0xFFFFFF;
+
+// varint по 7 бит, младшие группы первыми; не длиннее 64 бит
+bool readSize(const uint8_t*& p, const uint8_t* end, uint64_t& value) {
+    value = 0;
+    int shift = 0;
+    while (p < end && shift < 64) {
+        uint8_t byte = *p++;
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        shift += 7;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Заголовок с проверкой размера результата по длине дельты; команды
+// начинаются с delta + header.opsOffset
+void readHeader(const uint8_t* delta, size_t deltaSize, Delta::Header& header) {
+    if (!Delta::parseHeader(delta, deltaSize, header)) {
+        throw std::runtime_error("Повреждён заголовок дельты");
+    }
+
+    // Команда занимает хотя бы байт и пишет не больше 0xFFFFFF байт (24-битная
+    // длина копирования): испорченный заголовок не заставит выделить гигабайты
+    if (header.resultSize > static_cast<uint64_t>(deltaSize - header.opsOffset) * MAX_OP_SIZE) {
+        throw std::runtime_error("Размер результата дельты не согласован с её длиной");
+    }
+}
+
+// Следующая команда с позиции p; отрезок копирования проверяется по baseSize
+inline void readOp(const uint8_t*& p, const uint8_t* end, uint64_t baseSize, Delta::Op& op) {
+    uint8_t cmd = *p++;
+    if (cmd & 0x80) {
+        // Байты смещения и длины, отмеченные битами команды; их не больше семи,
+        // и пересчитывать их нужно только у самого конца дельты
+        if (end - p < 7) {
+            int argumentBytes = 0;
+            for (int i = 0; i < 7; i++) {
+                argumentBytes += (cmd >> i) & 1;
+            }
+            if (end - p < argumentBytes) {
+                throw std::runtime_error("Дельта обрывается посреди команды копирования");
+            }
+        }
+        uint64_t offset = 0;
+        uint64_t size = 0;
+        for (int i = 0; i < 4; i++) {
+            if (cmd & (1 << i)) {
+                offset |= static_cast<uint64_t>(*p++) << (i * 8);
+            }
+        }
+        for (int i = 0; i < 3; i++) {
+            if (cmd & (1 << (i + 4))) {
+                size |= static_cast<uint64_t>(*p++) << (i * 8);
+            }
+        }
+        if (size == 0) {
+            size = 0x10000;
+        }
+        if (offset > baseSize || size > baseSize - offset) {
+            throw std::runtime_error("Копирование за границу базы дельты");
+        }
+        op.literal = nullptr;
+        op.offset = offset;
+        op.size = size;
+    } else if (cmd) {
+        if (end - p < cmd) {
+            throw std::runtime_error("Дельта обрывается посреди вставки");
+        }
+        op.literal = p;
+        op.offset = 0;
+        op.size = cmd;
+        p += cmd;
+    } else {
+        throw std::runtime_error("Зарезервированная команда 0 в дельте");
+    }
+}
+
+// Добавление команды, которая пишет с позиции position, со склейкой
+// с предыдущей, если отрезки идут подряд
+void appendOp(Delta::Program& program, const Delta::Op& op, uint64_t position) {
+    if (!program.ops.empty()) {
+        Delta::Op& last = program.ops.back();
+        if (!op.literal && !last.literal && last.offset + last.size == op.offset) {
+            last.size += op.size;
+            return;
+        }
+        if (op.literal && last.literal && last.literal + last.size == op.literal) {
+            last.size += op.size;
+            return;
+        }
+    }
+    program.ops.push_back(op);
+    program.starts.push_back(position);
+}
+}
+
+bool Delta::parseHeader(const uint8_t* delta, size_t deltaSize, Header& header) {
+    const uint8_t* p = delta;
+    const uint8_t* end = delta + deltaSize;
+    if (!readSize(p, end, header.baseSize) || !readSize(p, end, header.resultSize)) {
+        return false;
+    }
+    header.opsOffset = static_cast<size_t>(p - delta);
+    return true;
+}
+
+void Delta::apply(const uint8_t* base, size_t baseSize, const uint8_t* delta, size_t deltaSize,
+                  std::vector<uint8_t>& result) {
+    Header header;
+    readHeader(delta, deltaSize, header);
+    if (header.baseSize != baseSize) {
+        throw std::runtime_error("Размер базы дельты " + std::to_string(baseSize) + " вместо " +
+                                 std::to_string(header.baseSize));
+    }
+    result.resize(static_cast<size_t>(header.resultSize));
+    uint8_t* out = result.data();
+    uint8_t* outEnd = out + result.size();
+
+    const uint8_t* p = delta + header.opsOffset;
+    const uint8_t* end = delta + deltaSize;
+    Op op;
+    while (p < end) {
+        readOp(p, end, baseSize, op);
+        if (op.size > static_cast<uint64_t>(outEnd - out)) {
+            throw std::runtime_error("Дельта пишет больше заявленного размера");
+        }
+        std::memcpy(out, op.literal ? op.literal : base + op.offset, static_cast<size_t>(op.size));
+        out += op.size;
+    }
+
+    if (out != outEnd) {
+        throw std::runtime_error("Дельта записала меньше заявленного размера");
+    }
+}
+
+void Delta::parse(const uint8_t* delta, size_t deltaSize, Program& program) {
+    Header header;
+    readHeader(delta, deltaSize, header);
+    program.baseSize = header.baseSize;
+    program.resultSize = header.resultSize;
+    program.ops.clear();
+    program.starts.clear();
+
+    const uint8_t* p = delta + header.opsOffset;
+    const uint8_t* end = delta + deltaSize;
+    uint64_t written = 0;
+    Op op;
+    while (p < end) {
+        readOp(p, end, header.baseSize, op);
+        if (op.size > header.resultSize - written) {
+            throw std::runtime_error("Дельта пишет больше заявленного размера");
+        }
+        appendOp(program, op, written);
+        written += op.size;
+    }
+    if (written != header.resultSize) {
+        throw std::runtime_error("Дельта записала меньше заявленного размера");
+    }
+}
+
+void Delta::compose(const Program& lower, const Program& upper, Program& result) {
+    if (upper.baseSize != lower.resultSize) {
+        throw std::runtime_error("Дельты цепочки не согласованы по размеру");
+    }
+
+    result.baseSize = lower.baseSize;
+    result.resultSize = upper.resultSize;
+    result.ops.clear();
+    result.starts.clear();
+    // Таблица переходов: для каждого блока в 2^shift байт результата lower —
+    // команда, которая пишет его начало. Блоков примерно столько же, сколько
+    // команд, и поиск команды по смещению копии — это чтение таблицы и пара
+    // шагов вперёд вместо двоичного поиска: копии прыгают по базе и назад
+    const std::vector<uint64_t>& starts = lower.starts;
+    uint64_t span = lower.resultSize / std::max<size_t>(starts.size(), 1);
+    int shift = 0;
+    while ((uint64_t(2) << shift) <= span) {
+        shift++;
+    }
+    thread_local std::vector<uint32_t> jump;
+    jump.resize(static_cast<size_t>(lower.resultSize >> shift) + 1);
+    for (size_t block = 0, i = 0; block < jump.size(); block++) {
+        uint64_t position = static_cast<uint64_t>(block) << shift;
+        while (i + 1 < starts.size() && starts[i + 1] <= position) {
+            i++;
+        }
+        jump[block] = static_cast<uint32_t>(i);
+    }
+
+    for (size_t k = 0; k < upper.ops.size(); k++) {
+        const Op& op = upper.ops[k];
+        uint64_t position = upper.starts[k];
+        if (op.literal) {
+            appendOp(result, op, position);
+            continue;
+        }
+
+        // Команды lower, которые записали отрезок [op.offset, op.offset + op.size)
+        size_t i = jump[op.offset >> shift];
+        while (i + 1 < starts.size() && starts[i + 1] <= op.offset) {
+            i++;
+        }
+        uint64_t from = op.offset;
+        uint64_t to = op.offset + op.size;
+        while (from < to) {
+            const Op& source = lower.ops[i];
+            uint64_t skip = from - starts[i];
+            uint64_t take = std::min(to, starts[i] + source.size) - from;
+            Op piece;
+            if (source.literal) {
+                piece.literal = source.literal + skip;
+            } else {
+                piece.offset = source.offset + skip;
+            }
+            piece.size = take;
+            appendOp(result, piece, position);
+            position += take;
+            from += take;
+            i++;
+        }
+    }
+}
+
+void Delta::apply(const uint8_t* base, size_t baseSize, const Program& program, std::vector<uint8_t>& result) {
+    if (program.baseSize != baseSize) {
+        throw std::runtime_error("Размер базы дельты " + std::to_string(baseSize) + " вместо " +
+                                 std::to_string(program.baseSize));
+    }
+    // Команды проверены при разборе, а композиция их границ не расширяет
+    result.resize(static_cast<size_t>(program.resultSize));
+    uint8_t* out = result.data();
+    for (const Op& op : program.ops) {
+        std::memcpy(out, op.literal ? op.literal : base + op.offset, static_cast<size_t>(op.size));
+        out += op.size;
+    }
+}
@@ -0,0 +1,68 @@
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#ifndef DELTA_HPP
+#define DELTA_HPP
+
+// Дельта git: два varint (размер базы и размер результата), затем команды.
+// Команда со старшим битом копирует отрезок базы: биты 0-3 отмечают байты
+// смещения, биты 4-6 — байты длины, длина 0 означает 0x10000. Команда 1..127
+// вставляет столько же следующих байт дельты, команда 0 зарезервирована.
+// Каждая команда проверяется: испорченная дельта не читает и не пишет за
+// границы буферов, а даёт runtime_error. Цепочку дельт можно свернуть в одну
+// программу от корневой базы и не собирать промежуточные объекты.
+class Delta {
+public:
+    struct Header {
+        uint64_t baseSize = 0;
+        uint64_t resultSize = 0;
+        // Начало команд в байтах дельты
+        size_t opsOffset = 0;
+    };
+
+    // Команда с разобранными аргументами: вставка size байт literal или,
+    // если literal == nullptr, копирование base[offset, offset + size)
+    struct Op {
+        const uint8_t* literal = nullptr;
+        uint64_t offset = 0;
+        uint64_t size = 0;
+    };
+
+    // Дельта как список команд. Вставки указывают в байты исходных дельт,
+    // поэтому те должны жить, пока программа используется
+    struct Program {
+        uint64_t baseSize = 0;
+        uint64_t resultSize = 0;
+        std::vector<Op> ops;
+        // starts[i] — позиция в результате, с которой пишет ops[i]
+        std::vector<uint64_t> starts;
+    };
+
+    // Разбор двух размеров; false, если дельта кончилась раньше
+    static bool parseHeader(const uint8_t* delta, size_t deltaSize, Header& header);
+
+    // Применение дельты к базе. Размер результата берётся из заголовка, память
+    // под него выделяется один раз (ёмкость result переиспользуется), отрезки
+    // копируются memcpy
+    static void apply(const uint8_t* base, size_t baseSize, const uint8_t* delta, size_t deltaSize,
+                      std::vector<uint8_t>& result);
+
+    static void apply(const std::vector<uint8_t>& base, const std::vector<uint8_t>& delta, std::vector<uint8_t>& result) {
+        apply(base.data(), base.size(), delta.data(), delta.size(), result);
+    }
+
+    // Разбор дельты в программу с теми же проверками, что у apply
+    static void parse(const uint8_t* delta, size_t deltaSize, Program& program);
+
+    // Композиция: upper применяется к результату lower, а получается программа
+    // сразу от базы lower. Копии upper разрезаются по командам lower, которые
+    // покрывают скопированный отрезок, поэтому цепочку выгоднее сворачивать от
+    // вершины: программа растёт только до того, что нужно запрошенному объекту
+    static void compose(const Program& lower, const Program& upper, Program& result);
+
+    // Один проход по базе: результат собирается из отрезков базы и вставок
+    static void apply(const uint8_t* base, size_t baseSize, const Program& program, std::vector<uint8_t>& result);
+};
+
+#endif
@@ -0,0 +1,128 @@
+#include "DeltaBaseCache.hpp"
+#include <algorithm>
+
+DeltaBaseCache::DeltaBaseCache(size_t memoryLimit, size_t shardCount)
+    : memoryLimit(memoryLimit), shardCount(std::max<size_t>(shardCount, 1)), shards(new Shard[this->shardCount]) {}
+
+DeltaBaseCache::Shard& DeltaBaseCache::shardFor(uint64_t offset) const {
+    // Соседние объекты должны попадать в разные сегменты
+    return shards[(offset * 0x9E3779B97F4A7C15ull >> 32) % shardCount];
+}
+
+DeltaBaseCache::Content DeltaBaseCache::get(uint64_t offset, GitObjectType& type) {
+    // Выключенный кэш не берёт блокировок
+    if (memoryLimit == 0) {
+        return nullptr;
+    }
+
+    Shard& shard = shardFor(offset);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.index.find(offset);
+    if (it == shard.index.end()) {
+        shard.stats.misses++;
+        return nullptr;
+    }
+
+    // Поднимаем запись в начало списка
+    shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+    shard.stats.hits++;
+    type = it->second->type;
+    return it->second->data;
+}
+
+void DeltaBaseCache::put(uint64_t offset, GitObjectType type, Content data) {
+    size_t size = data->size();
+    // Объект больше всего бюджета только вытеснил бы остальные
+    if (size > memoryLimit) {
+        return;
+    }
+
+    Shard& shard = shardFor(offset);
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (shard.index.count(offset)) {
+            return;
+        }
+        if (evictUntilFits(shard, size) && reserve(size)) {
+            insert(shard, offset, type, std::move(data));
+            return;
+        }
+    }
+
+    // Своих записей не хватило: место освобождают остальные сегменты. Мьютексы
+    // берутся по одному, чтобы потоки не ждали друг друга по кругу
+    size_t home = &shard - shards.get();
+    for (size_t step = 1; step < shardCount; step++) {
+        Shard& other = shards[(home + step) % shardCount];
+        std::lock_guard<std::mutex> lock(other.mutex);
+        if (evictUntilFits(other, size)) {
+            break;
+        }
+    }
+
+    // Пока мьютекс был отпущен, другие потоки могли занять освобождённое место
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (!shard.index.count(offset) && evictUntilFits(shard, size) && reserve(size)) {
+        insert(shard, offset, type, std::move(data));
+    }
+}
+
+void DeltaBaseCache::insert(Shard& shard, uint64_t offset, GitObjectType type, Content data) {
+    size_t size = data->size();
+    shard.lru.push_front({offset, type, std::move(data)});
+    shard.index[offset] = shard.lru.begin();
+    shard.memoryUsed += size;
+}
+
+bool DeltaBaseCache::reserve(size_t size) {
+    // Проверка и прибавление одним шагом: иначе два сегмента могли бы
+    // одновременно решить, что место есть
+    size_t used = totalUsed;
+    while (used + size <= memoryLimit) {
+        if (totalUsed.compare_exchange_weak(used, used + size)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool DeltaBaseCache::evictUntilFits(Shard& shard, size_t incoming) {
+    while (!shard.lru.empty() && totalUsed + incoming > memoryLimit) {
+        const Entry& victim = shard.lru.back();
+        shard.memoryUsed -= victim.data->size();
+        totalUsed -= victim.data->size();
+        shard.index.erase(victim.offset);
+        shard.lru.pop_back();
+        shard.stats.evictions++;
+    }
+    return totalUsed + incoming <= memoryLimit;
+}
+
+void DeltaBaseCache::setMemoryLimit(size_t limit) {
+    memoryLimit = limit;
+    for (size_t i = 0; i < shardCount; i++) {
+        std::lock_guard<std::mutex> lock(shards[i].mutex);
+        evictUntilFits(shards[i], 0);
+    }
+}
+
+void DeltaBaseCache::clear() {
+    for (size_t i = 0; i < shardCount; i++) {
+        std::lock_guard<std::mutex> lock(shards[i].mutex);
+        totalUsed -= shards[i].memoryUsed;
+        shards[i].lru.clear();
+        shards[i].index.clear();
+        shards[i].memoryUsed = 0;
+    }
+}
+
+DeltaBaseCache::Stats DeltaBaseCache::statistics() const {
+    Stats total;
+    for (size_t i = 0; i < shardCount; i++) {
+        std::lock_guard<std::mutex> lock(shards[i].mutex);
+        total.hits += shards[i].stats.hits;
+        total.misses += shards[i].stats.misses;
+        total.evictions += shards[i].stats.evictions;
+    }
+    return total;
+}
@@ -0,0 +1,85 @@
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "PackedObject.hpp"
+
+#ifndef DELTABASECACHE_HPP
+#define DELTABASECACHE_HPP
+
+// LRU-кэш распакованных баз дельт, ключ — смещение объекта в pack файле.
+// Суммарный размер хранимых данных не превышает заданного бюджета.
+// Кэш потокобезопасен: записи раскладываются по shardCount сегментам со своими
+// мьютексами и LRU-списками. Бюджет у сегментов общий, поэтому база почти во
+// весь бюджет тоже кэшируется: сегмент, которому не хватает места, вытесняет
+// сначала свои записи, затем записи остальных сегментов.
+class DeltaBaseCache {
+public:
+    // Как core.deltaBaseCacheLimit в git
+    static constexpr size_t DEFAULT_MEMORY_LIMIT = 96 * 1024 * 1024;
+
+    using Content = std::shared_ptr<const std::vector<uint8_t>>;
+
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+    };
+
+private:
+    struct Entry {
+        uint64_t offset;
+        GitObjectType type;
+        Content data;
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        size_t memoryUsed = 0;
+        std::list<Entry> lru;  // в начале — недавно использованные
+        std::unordered_map<uint64_t, std::list<Entry>::iterator> index;
+        Stats stats;
+    };
+
+    size_t memoryLimit;
+    size_t shardCount;
+    std::unique_ptr<Shard[]> shards;
+    // Сумма memoryUsed всех сегментов
+    std::atomic<size_t> totalUsed{0};
+
+    Shard& shardFor(uint64_t offset) const;
+
+    // Вытеснение из shard (его мьютекс захвачен), пока incoming не уложится
+    // в общий бюджет; false, если записей сегмента на это не хватило
+    bool evictUntilFits(Shard& shard, size_t incoming);
+
+    // Атомарно занимает size байт бюджета; false, если они уже не помещаются
+    bool reserve(size_t size);
+
+    // Место под запись уже занято через reserve
+    void insert(Shard& shard, uint64_t offset, GitObjectType type, Content data);
+
+public:
+    explicit DeltaBaseCache(size_t memoryLimit = DEFAULT_MEMORY_LIMIT, size_t shardCount = 1);
+
+    // nullptr, если объекта нет в кэше
+    Content get(uint64_t offset, GitObjectType& type);
+
+    void put(uint64_t offset, GitObjectType type, Content data);
+
+    // Не вызывать одновременно с get/put
+    void setMemoryLimit(size_t limit);
+
+    void clear();
+
+    size_t memoryLimitBytes() const { return memoryLimit; }
+
+    size_t memoryUsage() const { return totalUsed; }
+
+    Stats statistics() const;
+};
+
+#endif
@@ -1,41 +1,50 @@
 #include "GitIdxParser.hpp"
+#include "CommitGraph.hpp"
+#include "CommitHeader.hpp"
 #include "GitPackParser.hpp"
+#include "PlantUmlPipe.hpp"
+#include "ParallelFor.hpp"
+#include "Sha1.hpp"
+#include <algorithm>
+#include <atomic>
 #include <cstdio>
-#include <sstream>
-#include <iomanip>
+#include <cstring>
 #include <iostream>
 #include <fstream>
 #include <filesystem>
+#include <mutex>
 
-int GitIdxParser::find_unix_timestamp(const std::string& data)
-{
-    std::string unixTimestamp;
-    for (const char& sym : data)
-    {
-        if (48 <= sym && sym <= 57)
-            unixTimestamp += sym;
-        else
-        {
-            if (unixTimestamp.length() == 10)
-                return std::stoi(unixTimestamp);
-            else
-                unixTimestamp = "";
-        }
-    }
-    if (unixTimestamp != "")
-    {
-        return std::stoi(unixTimestamp);
-    }
-    return -1;
+std::string GitIdxParser::bytesToHex(const unsigned char* bytes, size_t length) {
+    std::string hex(length * 2, '0');
+    bytesToHex(bytes, length, &hex[0]);
+    return hex;
 }
 
-std::string GitIdxParser::bytesToHex(const unsigned char* bytes, size_t length) {
-    std::stringstream ss;
+void GitIdxParser::bytesToHex(const unsigned char* bytes, size_t length, char* out) {
+    static const char digits[] = "0123456789abcdef";
     for (size_t i = 0; i < length; i++) {
-        ss << std::hex << std::setfill('0') << std::setw(2)
-           << static_cast<int>(bytes[i]);
+        out[i * 2] = digits[bytes[i] >> 4];
+        out[i * 2 + 1] = digits[bytes[i] & 0x0F];
+    }
+}
+
+bool GitIdxParser::hexToBytes(std::string_view hex, unsigned char* bytes) {
+    if (hex.size() != 40) {
+        return false;
+    }
+    for (size_t i = 0; i < 20; i++) {
+        int value = 0;
+        for (size_t j = 0; j < 2; j++) {
+            char c = hex[i * 2 + j];
+            value <<= 4;
+            if (c >= '0' && c <= '9') value |= c - '0';
+            else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F') value |= c - 'A' + 10;
+            else return false;
+        }
+        bytes[i] = static_cast<unsigned char>(value);
     }
-    return ss.str();
+    return true;
 }
 
 bool GitIdxParser::readExactly(std::ifstream& file, char* buffer, size_t size) {
@@ -43,21 +52,56 @@ bool GitIdxParser::readExactly(std::ifstream& file, char* buffer, size_t size) {
     return file.gcount() == static_cast<std::streamsize>(size);
 }
 
-bool GitIdxParser::parseFile(const std::string& filename) {
-    std::ifstream file(filename, std::ios::binary);
+bool GitIdxParser::parseFile(const std::string& filename, bool verifyChecksum) {
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
     if (!file.is_open()) {
         std::cerr << "Не удалось открыть файл: " << filename << std::endl;
         return false;
     }
 
-    // Читаем и проверяем заголовок
-    uint32_t header;
-    if (!readExactly(file, reinterpret_cast<char*>(&header), sizeof(header))) {
+    // Файл целиком читается одним вызовом, таблицы разбираются по месту
+    mapped.reset();
+    storage.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0, std::ios::beg);
+    if (!readExactly(file, reinterpret_cast<char*>(storage.data()), storage.size())) {
+        std::cerr << "Ошибка чтения файла индекса" << std::endl;
+        return false;
+    }
+    file.close();
+
+    return parseTables(storage.data(), storage.size(), verifyChecksum);
+}
+
+bool GitIdxParser::mapFile(const std::string& filename, bool verifyChecksum) {
+    try {
+        mapped = std::make_unique<MappedFile>(filename);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return false;
+    }
+    storage.clear();
+
+    if (!mapped->isMapped()) {
+        // mmap недоступен: читаем файл в память, как parseFile
+        storage.resize(mapped->size());
+        if (!mapped->readAt(0, storage.data(), storage.size())) {
+            std::cerr << "Ошибка чтения файла индекса" << std::endl;
+            return false;
+        }
+        return parseTables(storage.data(), storage.size(), verifyChecksum);
+    }
+    return parseTables(mapped->data(), mapped->size(), verifyChecksum);
+}
+
+bool GitIdxParser::parseTables(const unsigned char* data, uint64_t size, bool verifyChecksum) {
+    numObjects = 0;
+    if (size < IDX_TABLES_OFFSET + IDX_TRAILER_SIZE) {
         std::cerr << "Ошибка чтения заголовка" << std::endl;
         return false;
     }
-    header = ntohl(header);
 
+    // Читаем и проверяем заголовок
+    uint32_t header = readBigEndian32(data);
     if (header != IDX_V2_MAGIC) {
         std::cerr << "Неверный формат файла. Прочитано: 0x"
                  << std::hex << header << std::dec << std::endl;
@@ -65,124 +109,301 @@ bool GitIdxParser::parseFile(const std::string& filename) {
     }
 
     // Читаем и проверяем версию
-    uint32_t version;
-    if (!readExactly(file, reinterpret_cast<char*>(&version), sizeof(version))) {
-        std::cerr << "Ошибка чтения версии" << std::endl;
-        return false;
-    }
-    version = ntohl(version);
-
+    uint32_t version = readBigEndian32(data + 4);
     if (version != 2) {
         std::cerr << "Неподдерживаемая версия: " << version << std::endl;
         return false;
     }
 
     // Читаем fanout таблицу
-    uint32_t fanout[256];
     for (int i = 0; i < 256; i++) {
-        if (!readExactly(file, reinterpret_cast<char*>(&fanout[i]), sizeof(uint32_t))) {
-            std::cerr << "Ошибка чтения fanout таблицы" << std::endl;
+        fanout[i] = readBigEndian32(data + 8 + i * 4);
+        if (i > 0 && fanout[i] < fanout[i - 1]) {
+            std::cerr << "Fanout таблица не монотонна" << std::endl;
             return false;
         }
-        fanout[i] = ntohl(fanout[i]);
     }
 
-    uint32_t numObjects = fanout[255];
-    entries.reserve(numObjects);
-
-    // Читаем SHA-1 хеши
-    for (uint32_t i = 0; i < numObjects; i++) {
-        IndexEntry entry;
-        unsigned char sha1Bytes[20];
-
-        if (!readExactly(file, reinterpret_cast<char*>(sha1Bytes), 20)) {
-            std::cerr << "Ошибка чтения SHA-1 хеша для объекта " << i << std::endl;
-            return false;
-        }
-
-        entry.sha1 = bytesToHex(sha1Bytes, 20);
-        entries.push_back(entry);
+    // Таблицы SHA-1, CRC32 и смещений идут подряд после fanout
+    uint64_t count = fanout[255];
+    if (size < IDX_TABLES_OFFSET + count * (20 + 4 + 4) + IDX_TRAILER_SIZE) {
+        std::cerr << "Файл индекса обрезан" << std::endl;
+        return false;
     }
+    shaTable = data + IDX_TABLES_OFFSET;
+    crcTable = reinterpret_cast<const uint32_t*>(shaTable + count * 20);
+    offsetTable = crcTable + count;
 
-    // Читаем CRC32
-    for (uint32_t i = 0; i < numObjects; i++) {
-        uint32_t crc;
-        if (!readExactly(file, reinterpret_cast<char*>(&crc), sizeof(crc))) {
-            std::cerr << "Ошибка чтения CRC32 для объекта " << i << std::endl;
-            return false;
-        }
-        entries[i].crc32 = ntohl(crc);
+    // Всё между таблицей смещений и концевиком — 64-битные смещения
+    largeOffsetTable = reinterpret_cast<const unsigned char*>(offsetTable + count);
+    uint64_t largeTableBytes = size - IDX_TRAILER_SIZE - (largeOffsetTable - data);
+    if (largeTableBytes % 8 != 0) {
+        std::cerr << "Некорректный размер таблицы 64-битных смещений" << std::endl;
+        return false;
     }
+    largeOffsetCount = largeTableBytes / 8;
+    packSha = data + size - IDX_TRAILER_SIZE;
 
-    // Читаем смещения
-    for (uint32_t i = 0; i < numObjects; i++) {
-        uint32_t offset;
-        if (!readExactly(file, reinterpret_cast<char*>(&offset), sizeof(offset))) {
-            std::cerr << "Ошибка чтения смещения для объекта " << i << std::endl;
+    if (verifyChecksum) {
+        unsigned char digest[20];
+        Sha1::hash(data, size - 20, digest);
+        if (std::memcmp(digest, data + size - 20, 20) != 0) {
+            std::cerr << "Контрольная сумма индекса не совпадает" << std::endl;
             return false;
         }
-        entries[i].offset = ntohl(offset);
     }
 
-    file.close();
+    numObjects = static_cast<uint32_t>(count);
     return true;
 }
 
 void GitIdxParser::printEntries(bool verbose) const {
-    for (size_t i = 0; i < entries.size(); i++) {
-        const auto& entry = entries[i];
+    char hex[41] = {};
+    for (size_t i = 0; i < objectCount(); i++) {
+        bytesToHex(sha1At(i), 20, hex);
         if (verbose) {
-            std::cout << "Объект " << i + 1 << "/" << entries.size() << ":\n"
-                     << "  SHA-1: " << entry.sha1 << "\n"
-                     << "  Смещение: 0x" << std::hex << entry.offset << std::dec << "\n"
-                     << "  CRC32: 0x" << std::hex << entry.crc32 << std::dec << "\n"
+            std::cout << "Объект " << i + 1 << "/" << objectCount() << ":\n"
+                     << "  SHA-1: " << hex << "\n"
+                     << "  Смещение: 0x" << std::hex << offsetAt(i) << std::dec << "\n"
+                     << "  CRC32: 0x" << std::hex << crc32At(i) << std::dec << "\n"
                      << "-------------------\n";
         } else {
-            std::cout << entry.sha1 << " @ " << entry.offset << "\n";
+            std::cout << hex << " @ " << offsetAt(i) << "\n";
         }
     }
 
-    std::cout << "Всего объектов: " << entries.size() << std::endl;
+    std::cout << "Всего объектов: " << objectCount() << std::endl;
 }
 
-void GitIdxParser::extractCommitsToPuml(const std::string& packFilePath, const int& from, const std::string& outputDir) {
-    try {
-        GitPackParser packParser(packFilePath);
-        pumlFile = outputDir + "commits.puml";
-        std::ofstream output(outputDir + "commits.puml");
-        output << "@startuml\ndigraph dependencies {\n";
-        for (const auto& entry : entries) {
+int64_t GitIdxParser::findObject(const unsigned char* sha1) const {
+    // Fanout сужает поиск до объектов с тем же первым байтом
+    uint32_t low = sha1[0] == 0 ? 0 : fanout[sha1[0] - 1];
+    uint32_t high = fanout[sha1[0]];
+
+    while (low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        int cmp = std::memcmp(sha1At(mid), sha1, 20);
+        if (cmp == 0) {
+            return mid;
+        }
+        if (cmp < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return -1;
+}
+
+uint64_t GitIdxParser::offsetAt(size_t i) const {
+    uint32_t offset = ntohl(offsetTable[i]);
+    if (!(offset & LARGE_OFFSET_FLAG)) {
+        return offset;
+    }
+
+    // Старший бит означает номер записи в таблице 64-битных смещений
+    uint32_t largeIndex = offset & ~LARGE_OFFSET_FLAG;
+    if (largeIndex >= largeOffsetCount) {
+        throw std::runtime_error("Некорректная ссылка на 64-битное смещение у объекта " + std::to_string(i));
+    }
+    const unsigned char* entry = largeOffsetTable + static_cast<uint64_t>(largeIndex) * 8;
+    return (static_cast<uint64_t>(readBigEndian32(entry)) << 32) | readBigEndian32(entry + 4);
+}
+
+bool GitIdxParser::findOffset(const unsigned char* sha1, uint64_t& offset) const {
+    int64_t index = findObject(sha1);
+    if (index < 0) {
+        return false;
+    }
+    offset = offsetAt(index);
+    return true;
+}
+
+bool GitIdxParser::decodeCommit(const GitPackParser& packParser, size_t i, const int& from, CommitRecord& record,
+                                std::vector<uint8_t>& content, bool composeDeltas) {
+    // Тип виден по заголовкам, поэтому деревья и блобы не распаковываются
+    if (packParser.peekType(offsetAt(i)) != GitObjectType::COMMIT) {
+        return false;
+    }
+
+    GitObjectType type = packParser.getObjectContent(offsetAt(i), content, composeDeltas);
+    return parseCommit(i, type, content, from, record);
+}
+
+bool GitIdxParser::parseCommit(size_t i, GitObjectType type, const std::vector<uint8_t>& content, const int& from,
+                               CommitRecord& record) {
+    return parseCommitObject(sha1At(i), type, content, from, record);
+}
+
+bool GitIdxParser::parseCommitObject(const unsigned char* sha1, GitObjectType type, const std::vector<uint8_t>& content,
+                                     const int& from, CommitRecord& record) {
+    if (type != GitObjectType::COMMIT) {
+        return false;
+    }
+
+    CommitHeader header;
+    if (!CommitHeader::parse(std::string_view(reinterpret_cast<const char*>(content.data()), content.size()), header)) {
+        std::cerr << "Некорректный заголовок коммита " << bytesToHex(sha1, 20) << "\n";
+        return false;
+    }
+    // Дата коммитера, как в commit-graph
+    if (header.committer.time < from) {
+        return false;
+    }
+
+    std::memcpy(record.id, sha1, 20);
+    record.time = static_cast<int>(header.committer.time);
+    record.parents.resize(header.parentCount());
+    for (size_t k = 0; k < header.parentCount(); k++) {
+        record.parents[k].assign(header.parent(k));
+    }
+    return true;
+}
+
+bool GitIdxParser::takeFromGraph(const ExtractOptions& options, const unsigned char* sha1, const int& from,
+                                 std::vector<CommitRecord>& commits) {
+    if (!options.commitGraph) {
+        return false;
+    }
+    int64_t pos = options.commitGraph->findCommit(sha1);
+    if (pos < 0) {
+        return false;
+    }
+    CommitRecord record;
+    if (options.commitGraph->commitRecord(pos, from, record)) {
+        commits.push_back(std::move(record));
+    }
+    return true;
+}
+
+void GitIdxParser::sortUniqueCommits(std::vector<CommitRecord>& commits) {
+    std::sort(commits.begin(), commits.end(), [](const CommitRecord& a, const CommitRecord& b) {
+        return std::memcmp(a.id, b.id, 20) < 0;
+    });
+    commits.erase(std::unique(commits.begin(), commits.end(), [](const CommitRecord& a, const CommitRecord& b) {
+        return std::memcmp(a.id, b.id, 20) == 0;
+    }), commits.end());
+}
+
+std::vector<CommitRecord> GitIdxParser::collectCommits(const std::string& packFilePath, const int& from,
+                                                       const ExtractOptions& options, DeltaBaseCache::Stats* stats,
+                                                       size_t* failures) {
+    // Парсер и его кэш баз дельт общие для всех потоков
+    GitPackParser packParser(packFilePath);
+    packParser.setIndex(this);
+    packParser.loadReverseIndex();
+    packParser.deltaBaseCache().setMemoryLimit(options.deltaCacheLimit);
+    return collectCommits(packParser, from, options, stats, failures);
+}
+
+std::vector<CommitRecord> GitIdxParser::collectCommits(const GitPackParser& packParser, const int& from,
+                                                       const ExtractOptions& options, DeltaBaseCache::Stats* stats,
+                                                       size_t* failures) {
+    unsigned threads = resolveThreadCount(options.threads);
+
+    std::vector<std::vector<CommitRecord>> found(threads);
+    std::atomic<size_t> skipped{0};
+    if (options.bulk) {
+        // Пакетный обход в порядке смещений; коммитов мало, общий мьютекс не мешает.
+        // Коммиты из commit-graph в обход не попадают
+        std::vector<uint64_t> offsets;
+        std::vector<size_t> items;
+        offsets.reserve(objectCount());
+        items.reserve(objectCount());
+        for (size_t i = 0; i < objectCount(); i++) {
+            if (!takeFromGraph(options, sha1At(i), from, found[0])) {
+                offsets.push_back(offsetAt(i));
+                items.push_back(i);
+            }
+        }
+        std::mutex foundMutex;
+        skipped += packParser.forEachObject(offsets, [&](size_t item, GitObjectType type, const std::vector<uint8_t>& content) {
+            CommitRecord record;
             try {
-                auto [type, content] = packParser.getObjectContent(entry.offset);
-                if (GitPackParser::objectTypeToString(type) == "commit") {
-                    std::string textContent(content.begin(), content.end());
-                    int time = find_unix_timestamp(textContent);
-                    if (!time)
-                    {
-                        std::cerr << "no unix timestamp\n";
+                if (parseCommit(items[item], type, content, from, record)) {
+                    std::lock_guard<std::mutex> lock(foundMutex);
+                    found[0].push_back(std::move(record));
+                }
+            } catch (const std::exception& e) {
+                skipped++;
+            }
+        }, threads, [](GitObjectType type) { return type == GitObjectType::COMMIT; });
+    } else {
+        parallelFor(objectCount(), threads, EXTRACT_GRAIN, [&](unsigned worker, size_t begin, size_t end) {
+            CommitRecord record;
+            std::vector<uint8_t> content;
+            for (size_t i = begin; i < end; i++) {
+                try {
+                    if (takeFromGraph(options, sha1At(i), from, found[worker])) {
+                        continue;
                     }
-                    if (time >= from)
-                    {
-                        std::string parent = textContent.substr(textContent.find("parent") + 7, 40);
-                        if (parent.back() == '\n')
-                            parent.pop_back();
-                        std::cout << "{\"hash\": \"" << entry.sha1 << "\", \"parent\": \"" << parent << "\"}\n";
-                        //plantuml_code += f'  "{parent}" -> "{commit["hash"]}";\n'
-                        output << "  \"" << entry.sha1 << "\";\n  \"" << parent << "\" -> \"" << entry.sha1 << "\";\n";
+                    if (decodeCommit(packParser, i, from, record, content, options.composeDeltas)) {
+                        found[worker].push_back(record);
                     }
+                } catch (const std::exception& e) {
+                    skipped++;
                 }
-            } catch (const std::exception& e) {
-
             }
+        });
+    }
+
+    // Порядок как при последовательном проходе: по SHA-1, то есть по индексу
+    std::vector<CommitRecord> commits;
+    for (std::vector<CommitRecord>& part : found) {
+        commits.insert(commits.end(), std::make_move_iterator(part.begin()), std::make_move_iterator(part.end()));
+    }
+    sortUniqueCommits(commits);
+
+    if (stats) {
+        *stats = packParser.deltaBaseCache().statistics();
+    }
+    if (failures) {
+        *failures = skipped;
+    }
+    return commits;
+}
+
+void GitIdxParser::extractCommitsToPuml(const std::string& packFilePath, const int& from, const std::string& outputDir,
+                                        const ExtractOptions& options) {
+    try {
+        DeltaBaseCache::Stats stats;
+        std::vector<CommitRecord> commits = collectCommits(packFilePath, from, options, &stats);
+        writeCommitsToPuml(commits, outputDir);
+
+        if (options.printStats) {
+            printCacheStats(stats);
         }
-        output << "}\n@enduml";
-        output.close();
     } catch (const std::exception& e) {
         std::cerr << "Ошибка при работе с pack файлом: " << e.what() << std::endl;
     }
 }
 
-std::string GitIdxParser::convertPumlToPng(const std::string& plantUmlJarPath)
+std::string GitIdxParser::writeCommitsToPuml(const std::vector<CommitRecord>& commits, const std::string& outputDir) {
+    std::string pumlFile = outputDir + "commits.puml";
+    std::ofstream output(pumlFile);
+    output << "@startuml\ndigraph dependencies {\n";
+    char sha1[41] = {};
+    for (const CommitRecord& commit : commits) {
+        bytesToHex(commit.id, 20, sha1);
+        std::cout << "{\"hash\": \"" << sha1 << "\", \"parent\": \""
+                  << (commit.parents.empty() ? "" : commit.parents[0]) << "\"}\n";
+        //plantuml_code += f'  "{parent}" -> "{commit["hash"]}";\n'
+        output << "  \"" << sha1 << "\";\n";
+        for (const std::string& parent : commit.parents) {
+            output << "  \"" << parent << "\" -> \"" << sha1 << "\";\n";
+        }
+    }
+    output << "}\n@enduml";
+    output.close();
+    return pumlFile;
+}
+
+void GitIdxParser::printCacheStats(const DeltaBaseCache::Stats& stats) {
+    std::cerr << "Кэш баз дельт: попаданий " << stats.hits << ", промахов " << stats.misses
+              << ", вытеснений " << stats.evictions << std::endl;
+}
+
+std::string GitIdxParser::convertPumlToPng(const std::string& pumlFile, const std::string& plantUmlJarPath)
 {
     if (!std::filesystem::exists(pumlFile)) {
         throw std::runtime_error("Файл " + pumlFile + " не найден.");
@@ -205,3 +426,11 @@ std::string GitIdxParser::convertPumlToPng(const std::string& plantUmlJarPath)
 
     return output_file;
 }
+
+std::string GitIdxParser::convertPumlToPng(const std::string& pumlFile, PlantUmlPipe& pipe)
+{
+    if (!std::filesystem::exists(pumlFile)) {
+        throw std::runtime_error("Файл " + pumlFile + " не найден.");
+    }
+    return pipe.renderFiles({pumlFile}, "png").front();
+}
@@ -1,37 +1,152 @@
 #include <arpa/inet.h>
+#include <cstring>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
+#include "BigEndian.hpp"
+#include "CommitRecord.hpp"
+#include "DeltaBaseCache.hpp"
+#include "MappedFile.hpp"
 
 #ifndef GITIDXPARSER_HPP
 #define GITIDXPARSER_HPP
 
+class CommitCache;
+class CommitGraph;
+
+// Настройки извлечения коммитов
+struct ExtractOptions {
+    size_t deltaCacheLimit = DeltaBaseCache::DEFAULT_MEMORY_LIMIT;
+    bool printStats = false;
+    // Число потоков разбора; 0 — по числу ядер
+    unsigned threads = 1;
+    // Пакетный обход pack файла в порядке смещений вместо поиска по индексу
+    bool bulk = false;
+    // Коммиты, которые покрывает commit-graph, берутся из него без распаковки
+    const CommitGraph* commitGraph = nullptr;
+    // Коммиты pack файлов и отдельных объектов, разобранные прошлыми запусками
+    CommitCache* resultCache = nullptr;
+    // Цепочки дельт сворачиваются в одну программу от корня (Delta::compose)
+    bool composeDeltas = false;
+};
+
+class GitPackParser;
+class PlantUmlPipe;
+
 class GitIdxParser {
     private:
-        static const uint32_t IDX_V2_MAGIC = 0xFF744F63;
+        static constexpr uint32_t IDX_V2_MAGIC = 0xFF744F63;
+        static constexpr uint64_t IDX_TABLES_OFFSET = 8 + 256 * 4;
+        static constexpr uint64_t IDX_TRAILER_SIZE = 40;
+        static constexpr uint32_t LARGE_OFFSET_FLAG = 0x80000000;
+        // Объектов в одной порции параллельного разбора
+        static constexpr size_t EXTRACT_GRAIN = 256;
+
+        // fanout[b] — число объектов, у которых первый байт SHA-1 не больше b
+        uint32_t fanout[256] = {};
+
+        // Число объектов и таблицы индекса в порядке SHA-1, как они лежат в файле:
+        // бинарные id по 20 байт, затем CRC32 и смещения в сетевом порядке байт
+        uint32_t numObjects = 0;
+        const unsigned char* shaTable = nullptr;
+        const uint32_t* crcTable = nullptr;
+        const uint32_t* offsetTable = nullptr;
+
+        // Таблица 64-битных смещений для объектов за отметкой 2 ГБ
+        const unsigned char* largeOffsetTable = nullptr;
+        uint64_t largeOffsetCount = 0;
 
-        std::string pumlFile = "";
+        // Контрольная сумма pack файла из концевика индекса
+        const unsigned char* packSha = nullptr;
 
-        struct IndexEntry {
-            std::string sha1;
-            uint32_t crc32;
-            uint32_t offset;
-        };
+        // Владелец байтов таблиц: копия файла в памяти или его отображение
+        std::vector<unsigned char> storage;
+        std::unique_ptr<MappedFile> mapped;
 
-        std::vector<IndexEntry> entries;
+        bool parseTables(const unsigned char* data, uint64_t size, bool verifyChecksum);
+
+        // Разбор i-го объекта; true, если это коммит не старше from. content — буфер
+        // для содержимого, переиспользуемый между объектами
+        bool decodeCommit(const GitPackParser& packParser, size_t i, const int& from, CommitRecord& record,
+                          std::vector<uint8_t>& content, bool composeDeltas);
+
+        bool parseCommit(size_t i, GitObjectType type, const std::vector<uint8_t>& content, const int& from,
+                         CommitRecord& record);
     public:
-        std::string bytesToHex(const unsigned char* bytes, size_t length);
+        static std::string bytesToHex(const unsigned char* bytes, size_t length);
+
+        // Запись 2 * length hex-символов в out без выделения памяти
+        static void bytesToHex(const unsigned char* bytes, size_t length, char* out);
+
+        // 40 hex-символов в 20 байт; false при неверном формате
+        static bool hexToBytes(std::string_view hex, unsigned char* bytes);
 
         bool readExactly(std::ifstream& file, char* buffer, size_t size);
 
-        int find_unix_timestamp(const std::string& data);
+        // Разбор содержимого объекта sha1; true, если это коммит не старше from
+        static bool parseCommitObject(const unsigned char* sha1, GitObjectType type, const std::vector<uint8_t>& content,
+                                      const int& from, CommitRecord& record);
+
+        // Если commit-graph из options покрывает sha1, запись берётся из него без
+        // распаковки и добавляется в commits, когда коммит не старше from; true — покрыт
+        static bool takeFromGraph(const ExtractOptions& options, const unsigned char* sha1, const int& from,
+                                  std::vector<CommitRecord>& commits);
+
+        // Сортировка по SHA-1 и удаление повторов одного коммита из разных хранилищ
+        static void sortUniqueCommits(std::vector<CommitRecord>& commits);
+
+        // Чтение индекса в память; verifyChecksum проверяет SHA-1 в конце файла
+        bool parseFile(const std::string& filename, bool verifyChecksum = false);
 
-        bool parseFile(const std::string& filename);
+        // Отображение индекса в память без копирования: таблицы читаются по месту,
+        // страницы подгружаются по мере обращения к ним
+        bool mapFile(const std::string& filename, bool verifyChecksum = false);
 
         void printEntries(bool verbose = false) const;
 
-        void extractCommitsToPuml(const std::string& packFilePath, const int& from, const std::string& outputDir);
+        size_t objectCount() const { return numObjects; }
+
+        const unsigned char* sha1At(size_t i) const { return shaTable + i * 20; }
+
+        uint32_t crc32At(size_t i) const { return ntohl(crcTable[i]); }
+
+        uint64_t offsetAt(size_t i) const;
+
+        // SHA-1 pack файла, которому принадлежит индекс
+        const unsigned char* packChecksum() const { return packSha; }
+
+        std::string hexAt(size_t i) const { return bytesToHex(sha1At(i), 20); }
+
+        // Номер объекта в индексе или -1, если его нет
+        int64_t findObject(const unsigned char* sha1) const;
+
+        bool findOffset(const unsigned char* sha1, uint64_t& offset) const;
+
+        // Коммиты не старше from в порядке SHA-1; stats — суммарная статистика кэшей,
+        // failures — число объектов, которые не удалось разобрать и пришлось пропустить
+        std::vector<CommitRecord> collectCommits(const std::string& packFilePath, const int& from,
+                                                 const ExtractOptions& options = {}, DeltaBaseCache::Stats* stats = nullptr,
+                                                 size_t* failures = nullptr);
+
+        // То же для уже открытого pack файла, индексом которого служит этот объект
+        std::vector<CommitRecord> collectCommits(const GitPackParser& packParser, const int& from,
+                                                 const ExtractOptions& options = {}, DeltaBaseCache::Stats* stats = nullptr,
+                                                 size_t* failures = nullptr);
+
+        void extractCommitsToPuml(const std::string& packFilePath, const int& from, const std::string& outputDir,
+                                  const ExtractOptions& options = {});
+
+        // commits.puml в outputDir и JSON строки коммитов в stdout; путь к commits.puml
+        static std::string writeCommitsToPuml(const std::vector<CommitRecord>& commits, const std::string& outputDir);
+
+        static void printCacheStats(const DeltaBaseCache::Stats& stats);
+
+        // PNG рядом с pumlFile; путь к нему
+        static std::string convertPumlToPng(const std::string& pumlFile, const std::string& plantUmlJarPath);
 
-        std::string convertPumlToPng(const std::string& plantUmlJarPath);
+        // То же через уже запущенный PlantUML в режиме -pipe, без нового запуска JVM
+        static std::string convertPumlToPng(const std::string& pumlFile, PlantUmlPipe& pipe);
 };
 
 #endif
@@ -1,15 +1,23 @@
 #include "GitPackParser.hpp"
+#include "Delta.hpp"
 #include <arpa/inet.h>
-
-GitPackParser::GitPackParser(const std::string& packFilePath) : packPath(packFilePath) {
-    packFile.open(packPath, std::ios::binary);
-    if (!packFile.is_open()) {
-        throw std::runtime_error("Не удалось открыть pack файл");
-    }
-
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <filesystem>
+#include <iostream>
+#include <numeric>
+#include "ParallelFor.hpp"
+#include <stdexcept>
+
+GitPackParser::GitPackParser(const std::string& packFilePath, bool useMmap)
+    : packPath(packFilePath), pack(packFilePath, useMmap) {
     // Проверяем сигнатуру pack файла
     uint32_t signature;
-    readExactly(reinterpret_cast<char*>(&signature), 4);
+    if (!readExactly(reinterpret_cast<char*>(&signature), 4)) {
+        throw std::runtime_error("Не удалось прочитать заголовок pack файла");
+    }
     signature = ntohl(signature);
     if (signature != PACK_SIGNATURE) {
         throw std::runtime_error("Неверная сигнатура pack файла");
@@ -17,33 +25,361 @@ GitPackParser::GitPackParser(const std::string& packFilePath) : packPath(packFil
 
     // Проверяем версию (должна быть 2 или 3)
     uint32_t version;
-    readExactly(reinterpret_cast<char*>(&version), 4);
+    if (!readExactly(reinterpret_cast<char*>(&version), 4)) {
+        throw std::runtime_error("Не удалось прочитать версию pack файла");
+    }
     version = ntohl(version);
     if (version != 2 && version != 3) {
         throw std::runtime_error("Неподдерживаемая версия pack файла");
     }
 }
 
-GitPackParser::~GitPackParser() {
-    if (packFile.is_open()) {
-        packFile.close();
+namespace {
+
+// Промежуточные буферы getObjectContent, живущие в потоке между вызовами
+struct DecodeWorkspace {
+    std::vector<PackedObject> chain;
+    std::vector<uint8_t> buffers[2];
+    std::vector<uint8_t> delta;
+    // Для композиции: распакованные дельты цепочки и программы над ними
+    std::vector<std::vector<uint8_t>> deltas;
+    Delta::Program composed;
+    Delta::Program lower;
+    Delta::Program next;
+};
+
+// deflate сжимает не сильнее чем в 1032 раза. Заявленный размер больше
+// этого испорчен, и память под него не выделяется
+constexpr uint64_t MAX_DEFLATE_RATIO = 1032;
+
+void checkInflatedSize(uint64_t compressed, uint64_t expectedSize) {
+    if (expectedSize / MAX_DEFLATE_RATIO > compressed) {
+        throw std::runtime_error("Размер объекта " + std::to_string(expectedSize) + " не согласован с " +
+                                 std::to_string(compressed) + " байтами сжатых данных");
+    }
+}
+
+template <typename T>
+void trimBuffer(std::vector<T>& buffer, size_t limit) {
+    if (buffer.capacity() * sizeof(T) > limit) {
+        std::vector<T>().swap(buffer);
+    }
+}
+
+}
+
+GitPackParser::~GitPackParser() = default;
+
+std::pair<GitObjectType, std::vector<uint8_t>> GitPackParser::getObjectContent(uint64_t offset,
+                                                                               bool composeDeltas) const {
+    std::vector<uint8_t> content;
+    GitObjectType type = getObjectContent(offset, content, composeDeltas);
+    return {type, std::move(content)};
+}
+
+GitObjectType GitPackParser::getObjectContent(uint64_t offset, std::vector<uint8_t>& content,
+                                              bool composeDeltas) const {
+    GitObjectType type;
+    if (DeltaBaseCache::Content cached = baseCache.get(offset, type)) {
+        content.assign(cached->begin(), cached->end());
+        return type;
+    }
+
+    thread_local DecodeWorkspace workspace;
+    std::vector<PackedObject>& chain = workspace.chain;
+    std::vector<uint8_t>* buffers = workspace.buffers;
+    std::vector<uint8_t>& delta = workspace.delta;
+    chain.clear();
+
+    // Спускаемся по цепочке до корня или до базы из кэша, читая только заголовки
+    DeltaBaseCache::Content cachedBase;
+    uint64_t current = offset;
+
+    while (true) {
+        PackedObject header = readObjectHeader(current);
+        if (header.type == GitObjectType::REF_DELTA) {
+            header.baseOffset = findRefDeltaBase(header.baseHash);
+        }
+        if (header.type == GitObjectType::OFS_DELTA || header.type == GitObjectType::REF_DELTA) {
+            // Цикл REF_DELTA в испорченном pack файле растил бы цепочку без конца
+            if (chain.size() >= MAX_DELTA_DEPTH) {
+                throw std::runtime_error("Слишком длинная цепочка дельт на смещении " + std::to_string(offset));
+            }
+            current = header.baseOffset;
+            chain.push_back(std::move(header));
+            if ((cachedBase = baseCache.get(current, type))) {
+                break;
+            }
+        } else {
+            type = header.type;
+            // Объект без дельт распаковывается сразу в буфер вызывающего
+            inflateInto(header.dataOffset, header.size, chain.empty() ? content : buffers[0]);
+            if (chain.empty()) {
+                return type;
+            }
+            baseCache.put(current, type, std::make_shared<const std::vector<uint8_t>>(buffers[0]));
+            break;
+        }
+    }
+
+    const std::vector<uint8_t>* base = cachedBase ? cachedBase.get() : &buffers[0];
+    if (composeDeltas && chain.size() > 1) {
+        // Дельта запрошенного объекта накладывается на дельту своей базы, та —
+        // на следующую и так до корня. Получается одна программа от базы, и
+        // объект собирается за один проход без промежуточных версий
+        std::vector<std::vector<uint8_t>>& deltas = workspace.deltas;
+        if (deltas.size() < chain.size()) {
+            deltas.resize(chain.size());
+        }
+        inflateInto(chain[0].dataOffset, chain[0].size, deltas[0]);
+        Delta::parse(deltas[0].data(), deltas[0].size(), workspace.composed);
+        for (size_t i = 1; i < chain.size(); i++) {
+            inflateInto(chain[i].dataOffset, chain[i].size, deltas[i]);
+            Delta::parse(deltas[i].data(), deltas[i].size(), workspace.lower);
+            Delta::compose(workspace.lower, workspace.composed, workspace.next);
+            std::swap(workspace.composed, workspace.next);
+        }
+        Delta::apply(base->data(), base->size(), workspace.composed, content);
+
+        trimBuffer(buffers[0], RETAINED_BUFFER_LIMIT);
+        for (std::vector<uint8_t>& buffer : deltas) {
+            trimBuffer(buffer, RETAINED_BUFFER_LIMIT);
+        }
+        for (Delta::Program* program : {&workspace.composed, &workspace.lower, &workspace.next}) {
+            trimBuffer(program->ops, RETAINED_BUFFER_LIMIT);
+            trimBuffer(program->starts, RETAINED_BUFFER_LIMIT);
+        }
+        return type;
+    }
+
+    // Применяем дельты от корня к запрошенному объекту, чередуя два буфера;
+    // последняя дельта пишет сразу в буфер вызывающего
+    int target = 1;
+    for (size_t i = chain.size(); i-- > 0;) {
+        inflateInto(chain[i].dataOffset, chain[i].size, delta);
+        std::vector<uint8_t>& output = i == 0 ? content : buffers[target];
+        applyDeltaInto(*base, delta, output);
+        base = &output;
+        target ^= 1;
+
+        // Непосредственную базу запрошенного объекта кэшируем: у соседей она часто общая
+        if (i == 1) {
+            baseCache.put(chain[0].baseOffset, type, std::make_shared<const std::vector<uint8_t>>(*base));
+        }
+    }
+
+    for (int k = 0; k < 2; k++) {
+        trimBuffer(buffers[k], RETAINED_BUFFER_LIMIT);
+    }
+    trimBuffer(delta, RETAINED_BUFFER_LIMIT);
+    return type;
+}
+
+uint64_t GitPackParser::findRefDeltaBase(const unsigned char* baseHash) const {
+    if (!index) {
+        throw std::runtime_error("Для REF_DELTA нужен индекс pack файла");
+    }
+
+    uint64_t offset;
+    if (!index->findOffset(baseHash, offset)) {
+        throw std::runtime_error("База REF_DELTA отсутствует в pack файле");
     }
+    return offset;
 }
 
-std::pair<GitObjectType, std::vector<uint8_t>> GitPackParser::getObjectContent(uint32_t offset) {
-    PackedObject obj = readObjectAtOffset(offset);
+GitObjectType GitPackParser::peekType(uint64_t offset) const {
+    PackedObject header = readObjectHeader(offset);
+    size_t depth = 0;
+    while (header.type == GitObjectType::OFS_DELTA || header.type == GitObjectType::REF_DELTA) {
+        uint64_t base = header.type == GitObjectType::OFS_DELTA ? header.baseOffset : findRefDeltaBase(header.baseHash);
+        // Смещения OFS_DELTA убывают, а REF_DELTA могут зациклиться в испорченном pack файле
+        if (++depth > MAX_DELTA_DEPTH) {
+            throw std::runtime_error("Слишком длинная цепочка дельт на смещении " + std::to_string(offset));
+        }
+        header = readObjectHeader(base);
+    }
+    return header.type;
+}
 
-    if (obj.type == GitObjectType::OFS_DELTA) {
-        // Рекурсивно получаем базовый объект
-        auto [baseType, baseContent] = getObjectContent(obj.baseOffset);
-        obj.type = baseType;
-        obj.data = applyDelta(baseContent, obj.data);
-    } else if (obj.type == GitObjectType::REF_DELTA) {
-        // TODO: Реализовать поиск базового объекта по хешу
-        throw std::runtime_error("REF_DELTA пока не поддерживается");
+uint64_t GitPackParser::peekSize(uint64_t offset) const {
+    PackedObject header = readObjectHeader(offset);
+    if (header.type != GitObjectType::OFS_DELTA && header.type != GitObjectType::REF_DELTA) {
+        return header.size;
     }
 
-    return {obj.type, obj.data};
+    // Два varint по 7 бит: размер базы и размер результата, не длиннее 10 байт каждый
+    uint8_t preamble[20];
+    size_t length = inflatePrefix(header.dataOffset, header.size, preamble, sizeof(preamble));
+    Delta::Header deltaHeader;
+    if (!Delta::parseHeader(preamble, length, deltaHeader)) {
+        throw std::runtime_error("Повреждён заголовок дельты на смещении " + std::to_string(offset));
+    }
+    return deltaHeader.resultSize;
+}
+
+size_t GitPackParser::inflatePrefix(uint64_t pos, size_t expectedSize, uint8_t* output, size_t maxBytes) const {
+    // Сжатая форма нескольких байт занимает немного: хватает короткого окна
+    InputCursor cursor;  // chunk не обнуляется: он только для pread
+    cursor.pos = pos;
+    cursor.end = compressedEnd(pos);
+    cursor.whole = false;
+    return Decompressor::forThread(Decompressor::Backend::ZLIB).inflatePrefix(
+        [this, &cursor](const uint8_t*& data) -> size_t {
+            return cursor.pos < cursor.end ? nextInput(cursor, data) : 0;
+        },
+        output, std::min(expectedSize, maxBytes));
+}
+
+size_t GitPackParser::forEachObject(const std::vector<uint64_t>& offsets, const ObjectVisitor& visit,
+                                    unsigned threads, const std::function<bool(GitObjectType)>& wantType) const {
+    // Заголовки всех объектов в порядке смещений: чтение pack файла идёт подряд
+    std::vector<size_t> order(offsets.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&offsets](size_t a, size_t b) { return offsets[a] < offsets[b]; });
+
+    // Одинаковые смещения идут в order подряд и дают один узел на все их номера.
+    // Объект с повреждённым заголовком в дерево не попадает
+    std::atomic<size_t> corrupt{0};
+    std::vector<BulkNode> nodes;
+    nodes.reserve(order.size());
+    for (size_t k = 0; k < order.size(); k++) {
+        uint64_t offset = offsets[order[k]];
+        if (k > 0 && offsets[order[k - 1]] == offset) {
+            if (!nodes.empty() && nodes.back().offset == offset) {
+                nodes.back().itemCount++;
+            }
+            continue;
+        }
+        try {
+            PackedObject header = readObjectHeader(offset);
+            if (header.type == GitObjectType::REF_DELTA) {
+                header.baseOffset = findRefDeltaBase(header.baseHash);
+            }
+            bool isDelta = header.type == GitObjectType::OFS_DELTA || header.type == GitObjectType::REF_DELTA;
+            nodes.push_back({offset, isDelta ? header.baseOffset : 0, header.dataOffset, header.size, k, 1,
+                             header.type});
+        } catch (const std::exception& e) {
+            corrupt++;
+        }
+    }
+
+    auto visitNode = [&](const BulkNode& node, GitObjectType type, const std::vector<uint8_t>& content) {
+        for (size_t k = node.firstItem; k < node.firstItem + node.itemCount; k++) {
+            visit(order[k], type, content);
+        }
+    };
+
+    auto findNode = [&nodes](uint64_t offset) -> const BulkNode* {
+        auto it = std::lower_bound(nodes.begin(), nodes.end(), offset,
+                                   [](const BulkNode& node, uint64_t value) { return node.offset < value; });
+        return it != nodes.end() && it->offset == offset ? &*it : nullptr;
+    };
+
+    // Рёбра база -> дельта, упорядоченные по базе, затем по смещению дельты.
+    // Корни — целые объекты и базы вне списка, их содержимое берётся отдельно
+    std::vector<std::pair<uint64_t, size_t>> edges;
+    std::vector<uint64_t> roots;
+    for (size_t i = 0; i < nodes.size(); i++) {
+        if (nodes[i].type == GitObjectType::OFS_DELTA || nodes[i].type == GitObjectType::REF_DELTA) {
+            edges.emplace_back(nodes[i].baseOffset, i);
+            if (!findNode(nodes[i].baseOffset)) {
+                roots.push_back(nodes[i].baseOffset);
+            }
+        } else {
+            roots.push_back(nodes[i].offset);
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    std::sort(roots.begin(), roots.end());
+    roots.erase(std::unique(roots.begin(), roots.end()), roots.end());
+
+    // Буферы уровней дерева живут между корнями, чтобы не выделять память заново
+    struct Frame {
+        std::vector<uint8_t> content;
+        GitObjectType type;
+        size_t nextEdge;
+        size_t endEdge;
+    };
+    struct Workspace {
+        std::vector<Frame> frames;
+        std::vector<uint8_t> delta;
+    };
+    unsigned workers = resolveThreadCount(threads);
+    std::vector<Workspace> workspaces(workers);
+
+    auto childEdges = [&edges](uint64_t offset, size_t& begin, size_t& end) {
+        auto range = std::equal_range(edges.begin(), edges.end(), std::make_pair(offset, size_t(0)),
+                                      [](const auto& a, const auto& b) { return a.first < b.first; });
+        begin = range.first - edges.begin();
+        end = range.second - edges.begin();
+    };
+
+    parallelFor(roots.size(), workers, BULK_GRAIN, [&](unsigned worker, size_t begin, size_t end) {
+        Workspace& workspace = workspaces[worker];
+        for (size_t r = begin; r < end; r++) {
+            if (workspace.frames.empty()) {
+                workspace.frames.emplace_back();
+            }
+            Frame& root = workspace.frames[0];
+            const BulkNode* rootNode = findNode(roots[r]);
+            // Корень, который не читается, пропускается со всем своим деревом
+            try {
+                if (wantType && !wantType(rootNode ? rootNode->type : peekType(roots[r]))) {
+                    continue;
+                }
+                if (rootNode) {
+                    root.type = rootNode->type;
+                    inflateInto(rootNode->dataOffset, rootNode->size, root.content);
+                } else {
+                    root.type = getObjectContent(roots[r], root.content);
+                }
+            } catch (const std::exception& e) {
+                corrupt++;
+                continue;
+            }
+            if (rootNode) {
+                visitNode(*rootNode, root.type, root.content);
+            }
+            childEdges(roots[r], root.nextEdge, root.endEdge);
+
+            // Обход в глубину без рекурсии: пока база на вершине стека, разбираем её дельты
+            size_t depth = 0;
+            while (true) {
+                Frame& frame = workspace.frames[depth];
+                if (frame.nextEdge == frame.endEdge) {
+                    if (depth == 0) {
+                        break;
+                    }
+                    depth--;
+                    continue;
+                }
+
+                const BulkNode& child = nodes[edges[frame.nextEdge++].second];
+                if (workspace.frames.size() <= depth + 1) {
+                    workspace.frames.emplace_back();
+                }
+                Frame& next = workspace.frames[depth + 1];
+                Frame& base = workspace.frames[depth];
+                // Дельта, которая не применяется, пропускается вместе со своими
+                // потомками: её ребро уже пройдено, а в стек она не попадает
+                try {
+                    inflateInto(child.dataOffset, child.size, workspace.delta);
+                    applyDeltaInto(base.content, workspace.delta, next.content);
+                } catch (const std::exception& e) {
+                    corrupt++;
+                    continue;
+                }
+                next.type = base.type;
+                visitNode(child, next.type, next.content);
+
+                childEdges(child.offset, next.nextEdge, next.endEdge);
+                if (next.nextEdge != next.endEdge) {
+                    depth++;
+                }
+            }
+        }
+    });
+    return corrupt;
 }
 
 std::string GitPackParser::objectTypeToString(GitObjectType type) {
@@ -58,92 +394,291 @@ std::string GitPackParser::objectTypeToString(GitObjectType type) {
     }
 }
 
-PackedObject GitPackParser::readObjectAtOffset(uint32_t offset) {
-    if (packFile.is_open()) {
-        packFile.close();
-    }
-    packFile.open(packPath, std::ios::binary);
-
-    packFile.seekg(offset, std::ios::beg);
-    if (!packFile.good()) {
-        throw std::runtime_error("Не удалось установить позицию в файле на смещение " + std::to_string(offset));
+PackedObject GitPackParser::readObjectHeader(uint64_t offset) const {
+    if (offset < PACK_HEADER_SIZE || offset >= pack.size()) {
+        throw std::runtime_error("Некорректное смещение объекта " + std::to_string(offset));
     }
 
-    uint8_t byte;
-    packFile.read(reinterpret_cast<char*>(&byte), 1);
+    uint64_t pos = offset;
+    uint8_t byte = readByteAt(pos);
 
     // Получаем тип объекта из первого байта
-    GitObjectType type = static_cast<GitObjectType>((byte >> 4) & 0x7);
+    uint8_t typeBits = (byte >> 4) & 0x7;
+    GitObjectType type = static_cast<GitObjectType>(typeBits);
+    if (typeBits == 0 || typeBits == 5) {
+        throw std::runtime_error("Неизвестный тип объекта на смещении " + std::to_string(offset));
+    }
 
-    // Получаем размер объекта
+    // Получаем размер объекта: 4 бита в первом байте, дальше по 7 бит
     uint64_t size = byte & 0x0F;
     int shift = 4;
-    if (byte & 0x80) {
-        size = readVariableLengthNumber(shift);
-    }
-
-    z_stream zs = {0};
-    if (inflateInit(&zs) != Z_OK) {
-        throw std::runtime_error("Ошибка инициализации zlib");
+    while (byte & 0x80) {
+        // Размер умещается в 64 бита; дальше сдвиг был бы неопределённым
+        if (shift > 57) {
+            throw std::runtime_error("Повреждён размер объекта на смещении " + std::to_string(offset));
+        }
+        byte = readByteAt(pos);
+        size |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        shift += 7;
     }
 
     PackedObject obj;
     obj.type = type;
     obj.size = size;
 
-    try {
-        obj.data = inflateData(zs, size);
-        inflateEnd(&zs);
-    } catch (...) {
-        inflateEnd(&zs);
-        throw;
-    }
-
-    // Обработка дельта-объектов
+    // Ссылка на базу дельты идёт до сжатых данных
     if (type == GitObjectType::OFS_DELTA) {
-        uint64_t negativeOffset = readVariableLengthNumber(shift);
+        byte = readByteAt(pos);
+        uint64_t negativeOffset = byte & 0x7F;
+        while (byte & 0x80) {
+            byte = readByteAt(pos);
+            negativeOffset = ((negativeOffset + 1) << 7) | (byte & 0x7F);
+        }
+        if (negativeOffset == 0 || negativeOffset > offset) {
+            throw std::runtime_error("Некорректное смещение базы дельты на " + std::to_string(offset));
+        }
         obj.baseOffset = offset - negativeOffset;
     } else if (type == GitObjectType::REF_DELTA) {
-        char baseHash[20];
-        readExactly(baseHash, 20);
-        obj.baseHash = std::string(baseHash, 20);
+        if (!pack.readAt(pos, obj.baseHash, 20)) {
+            throw std::runtime_error("Неожиданный конец pack файла");
+        }
+        pos += 20;
     }
 
+    obj.dataOffset = pos;
     return obj;
 }
 
-std::vector<uint8_t> GitPackParser::inflateData(z_stream& zs, size_t expectedSize) {
-    std::vector<uint8_t> output;
-    std::vector<uint8_t> buffer(CHUNK_SIZE);
-    output.reserve(expectedSize);
+PackedObject GitPackParser::readObjectAtOffset(uint64_t offset) const {
+    PackedObject obj = readObjectHeader(offset);
+    inflateInto(obj.dataOffset, obj.size, obj.data);
+    return obj;
+}
 
-    do {
-        char input[CHUNK_SIZE];
-        packFile.read(input, CHUNK_SIZE);
-        size_t bytesRead = packFile.gcount();
+void GitPackParser::inflateInto(uint64_t pos, size_t expectedSize, std::vector<uint8_t>& output) const {
+    // Без обратного индекса граница — конец pack файла: оценка грубее, но
+    // и она не даёт выделить память по любому числу из заголовка
+    uint64_t end = compressedEnd(pos);
+    checkInflatedSize(end > pos ? end - pos : 0, expectedSize);
+
+    if (!reverseIndex) {
+        // Границы неизвестны: zlib читает поток порциями, пока тот не закончится
+        InputCursor cursor;
+        cursor.pos = pos;
+        cursor.end = end;
+        cursor.whole = true;
+        output.resize(expectedSize);
+        Decompressor::forThread(Decompressor::Backend::ZLIB).inflate(
+            [this, &cursor](const uint8_t*& data) -> size_t { return nextInput(cursor, data); }, output.data(),
+            expectedSize);
+        return;
+    }
 
-        if (bytesRead == 0) break;
+    // Сжатые данные объекта целиком: из отображения без копирования, иначе через pread
+    thread_local std::vector<uint8_t> scratch;
+    const uint8_t* input = pack.view(pos, static_cast<size_t>(end - pos), scratch);
+    output.resize(expectedSize);
+    Decompressor::forThread(decompressorBackend).inflate(input, static_cast<size_t>(end - pos), output.data(),
+                                                         expectedSize);
+    trimBuffer(scratch, RETAINED_BUFFER_LIMIT);
+}
 
-        zs.avail_in = bytesRead;
-        zs.next_in = reinterpret_cast<Bytef*>(input);
+size_t GitPackParser::nextInput(InputCursor& cursor, const uint8_t*& data) const {
+    if (cursor.pos >= cursor.end) {
+        throw std::runtime_error(cursor.end < pack.size() ? "Сжатые данные выходят за границу объекта"
+                                                          : "Неожиданный конец pack файла");
+    }
+    uint64_t available = cursor.end - cursor.pos;
+    size_t n = static_cast<size_t>(cursor.whole && pack.isMapped() ? available
+                                                                    : std::min<uint64_t>(available, CHUNK_SIZE));
+    if (pack.isMapped()) {
+        // Подаём zlib байты прямо из отображения, без копирования
+        data = pack.data() + cursor.pos;
+    } else {
+        if (!pack.readAt(cursor.pos, cursor.chunk, n)) {
+            throw std::runtime_error("Ошибка чтения pack файла");
+        }
+        data = cursor.chunk;
+    }
+    cursor.pos += n;
+    return n;
+}
 
-        do {
-            zs.avail_out = buffer.size();
-            zs.next_out = buffer.data();
+uint64_t GitPackParser::compressedEnd(uint64_t pos) const {
+    return reverseIndex ? reverseIndex->endOf(pos) : pack.size();
+}
 
-            int ret = inflate(&zs, Z_NO_FLUSH);
-            if (ret != Z_OK && ret != Z_STREAM_END) {
-                throw std::runtime_error("Ошибка декомпрессии иди нахуй");
-            }
+void GitPackParser::loadReverseIndex() {
+    if (!index) {
+        throw std::runtime_error("Для обратного индекса нужен индекс pack файла");
+    }
+    std::unique_ptr<PackReverseIndex> rev = std::make_unique<PackReverseIndex>();
+    std::filesystem::path revPath = std::filesystem::path(packPath).replace_extension(".rev");
+    if (!std::filesystem::exists(revPath) || !rev->load(revPath.string(), *index, pack.size())) {
+        rev->build(*index, pack.size());
+    }
+    reverseIndex = std::move(rev);
+}
+
+GitPackParser::SizeStats GitPackParser::sizeStatistics() const {
+    if (!reverseIndex) {
+        throw std::runtime_error("Для размеров объектов нужен обратный индекс");
+    }
+    SizeStats stats;
+    for (size_t r = 0; r < reverseIndex->objectCount(); r++) {
+        uint64_t offset = reverseIndex->offsetAt(r);
+        uint64_t size = reverseIndex->diskSizeAt(r);
+        uint64_t pos = offset;
+        // Тип — в битах 4-6 первого байта заголовка
+        int type = (readByteAt(pos) >> 4) & 0x7;
+        stats.objects[type]++;
+        stats.bytes[type] += size;
+        if (size > stats.largest) {
+            stats.largest = size;
+            stats.largestOffset = offset;
+        }
+    }
+    return stats;
+}
+
+void GitPackParser::printSizeStats(const SizeStats& stats) {
+    uint64_t total = 0;
+    for (int type = 1; type < 8; type++) {
+        total += stats.bytes[type];
+    }
+    std::cerr << "Размер объектов в pack файлах: " << total << " байт\n";
+    for (int type = 1; type < 8; type++) {
+        if (stats.objects[type] > 0) {
+            std::cerr << "  " << objectTypeToString(static_cast<GitObjectType>(type)) << ": " << stats.objects[type]
+                      << " объектов, " << stats.bytes[type] << " байт, в среднем "
+                      << stats.bytes[type] / stats.objects[type] << "\n";
+        }
+    }
+    std::cerr << "  самый большой объект: " << stats.largest << " байт на смещении " << stats.largestOffset << "\n";
+}
+
+void GitPackParser::setDecompressor(Decompressor::Backend backend) {
+    if (!Decompressor::isAvailable(backend)) {
+        throw std::runtime_error("Распаковщик " + Decompressor::backendName(backend) + " не подключён при сборке");
+    }
+    decompressorBackend = backend;
+}
 
-            size_t inflatedSize = buffer.size() - zs.avail_out;
-            output.insert(output.end(), buffer.begin(), buffer.begin() + inflatedSize);
+GitPackParser::InflateBenchmark GitPackParser::benchmarkInflate(Decompressor::Backend backend) const {
+    if (!reverseIndex) {
+        throw std::runtime_error("Для замера распаковки нужен обратный индекс");
+    }
+    Decompressor& decompressor = Decompressor::forThread(backend);
+    std::vector<uint8_t> scratch, output;
+    InflateBenchmark result;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < reverseIndex->objectCount(); r++) {
+        PackedObject header = readObjectHeader(reverseIndex->offsetAt(r));
+        size_t compressed = static_cast<size_t>(compressedEnd(header.dataOffset) - header.dataOffset);
+        checkInflatedSize(compressed, header.size);
+        const uint8_t* input = pack.view(header.dataOffset, compressed, scratch);
+        output.resize(header.size);
+        decompressor.inflate(input, compressed, output.data(), output.size());
+        result.objects++;
+        result.compressedBytes += compressed;
+        result.inflatedBytes += header.size;
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
 
-        } while (zs.avail_out == 0);
+void GitPackParser::printInflateBenchmark(Decompressor::Backend backend, const InflateBenchmark& result) {
+    const double megabyte = 1024.0 * 1024.0;
+    double seconds = std::max(result.seconds, 1e-9);
+    std::cerr << Decompressor::backendName(backend) << ": " << result.objects << " объектов, "
+              << result.compressedBytes / megabyte << " МБ -> " << result.inflatedBytes / megabyte << " МБ за "
+              << result.seconds << " с, " << result.inflatedBytes / megabyte / seconds << " МБ/с распакованных, "
+              << result.compressedBytes / megabyte / seconds << " МБ/с сжатых\n";
+}
 
-    } while (packFile.good());
+GitPackParser::DeltaBenchmark GitPackParser::benchmarkDelta() const {
+    // Пары база-дельта копятся порциями, чтобы распаковка не попадала в замер
+    std::vector<std::pair<std::vector<uint8_t>, std::vector<uint8_t>>> batch;
+    size_t batchBytes = 0;
+    std::vector<uint8_t> result;
+    DeltaBenchmark benchmark;
+
+    auto applyBatch = [&]() {
+        double best = 0;
+        for (int round = 0; round < BENCHMARK_ROUNDS; round++) {
+            auto start = std::chrono::steady_clock::now();
+            for (const auto& [base, delta] : batch) {
+                Delta::apply(base, delta, result);
+            }
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            best = round == 0 ? seconds : std::min(best, seconds);
+        }
+        benchmark.seconds += best;
+        batch.clear();
+        batchBytes = 0;
+    };
+
+    size_t count = index ? index->objectCount() : 0;
+    for (size_t i = 0; i < count; i++) {
+        PackedObject header = readObjectHeader(index->offsetAt(i));
+        if (header.type == GitObjectType::REF_DELTA) {
+            header.baseOffset = findRefDeltaBase(header.baseHash);
+        } else if (header.type != GitObjectType::OFS_DELTA) {
+            continue;
+        }
+        std::vector<uint8_t> delta;
+        std::vector<uint8_t> base;
+        Delta::Header deltaHeader;
+        // Испорченная дельта не замеряется: apply бросил бы посреди пачки
+        try {
+            inflateInto(header.dataOffset, header.size, delta);
+            base = getObjectContent(header.baseOffset).second;
+        } catch (const std::runtime_error&) {
+            benchmark.corrupt++;
+            continue;
+        }
+        if (!Delta::parseHeader(delta.data(), delta.size(), deltaHeader) || deltaHeader.baseSize != base.size()) {
+            benchmark.corrupt++;
+            continue;
+        }
+        benchmark.deltas++;
+        benchmark.deltaBytes += delta.size();
+        benchmark.resultBytes += deltaHeader.resultSize;
+        batchBytes += base.size() + delta.size();
+        batch.emplace_back(std::move(base), std::move(delta));
+        if (batchBytes >= BENCHMARK_BATCH_BYTES) {
+            applyBatch();
+        }
+    }
+    applyBatch();
+    return benchmark;
+}
 
-    return output;
+void GitPackParser::printDeltaBenchmark(const DeltaBenchmark& result) {
+    const double megabyte = 1024.0 * 1024.0;
+    double seconds = std::max(result.seconds, 1e-9);
+    std::cerr << "дельты: " << result.deltas << " шт., " << result.deltaBytes / megabyte << " МБ -> "
+              << result.resultBytes / megabyte << " МБ за " << result.seconds << " с, "
+              << result.resultBytes / megabyte / seconds << " МБ/с результата, "
+              << result.deltas / seconds << " дельт/с";
+    if (result.corrupt) {
+        std::cerr << ", пропущено испорченных: " << result.corrupt;
+    }
+    std::cerr << "\n";
+}
+
+uint8_t GitPackParser::readByteAt(uint64_t& pos) const {
+    if (pos >= pack.size()) {
+        throw std::runtime_error("Неожиданный конец pack файла");
+    }
+    uint8_t byte;
+    if (pack.isMapped()) {
+        byte = pack.data()[pos];
+    } else if (!pack.readAt(pos, &byte, 1)) {
+        throw std::runtime_error("Ошибка чтения pack файла");
+    }
+    pos++;
+    return byte;
 }
 
 uint64_t GitPackParser::readVariableLengthNumber(int& shift) {
@@ -152,7 +687,9 @@ uint64_t GitPackParser::readVariableLengthNumber(int& shift) {
     shift = 0;
 
     do {
-        packFile.read(reinterpret_cast<char*>(&byte), 1);
+        if (!readExactly(reinterpret_cast<char*>(&byte), 1)) {
+            break;
+        }
         result |= (static_cast<uint64_t>(byte & 0x7F) << shift);
         shift += 7;
     } while (byte & 0x80);
@@ -161,48 +698,21 @@ uint64_t GitPackParser::readVariableLengthNumber(int& shift) {
 }
 
 bool GitPackParser::readExactly(char* buffer, size_t size) {
-    packFile.read(buffer, size);
-    return packFile.gcount() == static_cast<std::streamsize>(size);
+    if (!pack.readAt(cursor, buffer, size)) {
+        return false;
+    }
+    cursor += size;
+    return true;
 }
 
 std::vector<uint8_t> GitPackParser::applyDelta(const std::vector<uint8_t>& baseData,
-                               const std::vector<uint8_t>& deltaData) {
+                               const std::vector<uint8_t>& deltaData) const {
     std::vector<uint8_t> result;
-    size_t pos = 0;
-
-    // Пропускаем размеры из дельты
-    while (pos < deltaData.size() && (deltaData[pos] & 0x80)) pos++;
-    pos++;
-    while (pos < deltaData.size() && (deltaData[pos] & 0x80)) pos++;
-    pos++;
-
-    while (pos < deltaData.size()) {
-        uint8_t cmd = deltaData[pos++];
-        if (cmd & 0x80) {  // Copy команда
-            uint64_t offset = 0, size = 0;
-            int shift = 0;
-            for (int i = 0; i < 7; i++) {
-                if (cmd & (1 << i)) {
-                    offset |= static_cast<uint64_t>(deltaData[pos++]) << shift;
-                    shift += 8;
-                }
-            }
-            shift = 0;
-            for (int i = 0; i < 4; i++) {
-                if (cmd & (1 << (i + 3))) {
-                    size |= static_cast<uint64_t>(deltaData[pos++]) << shift;
-                    shift += 8;
-                }
-            }
-            result.insert(result.end(),
-                        baseData.begin() + offset,
-                        baseData.begin() + offset + size);
-        } else if (cmd) {  // Insert команда
-            result.insert(result.end(),
-                        deltaData.begin() + pos,
-                        deltaData.begin() + pos + cmd);
-            pos += cmd;
-        }
-    }
+    applyDeltaInto(baseData, deltaData, result);
     return result;
 }
+
+void GitPackParser::applyDeltaInto(const std::vector<uint8_t>& baseData, const std::vector<uint8_t>& deltaData,
+                                   std::vector<uint8_t>& result) {
+    Delta::apply(baseData, deltaData, result);
+}
@@ -1,39 +1,212 @@
-#include <fstream>
-#include <zlib.h>
+#include <functional>
+#include <memory>
+#include "Decompressor.hpp"
+#include "DeltaBaseCache.hpp"
+#include "GitIdxParser.hpp"
+#include "MappedFile.hpp"
 #include "PackedObject.hpp"
+#include "PackReverseIndex.hpp"
 
 #ifndef GITPACKPARSER_HPP
 #define GITPACKPARSER_HPP
 
+// Константные методы чтения объектов потокобезопасны: pack читается из
+// отображения или через pread по явной позиции, у каждого потока свой распаковщик.
+// Один парсер можно разделять между потоками без внешней синхронизации.
 class GitPackParser {
 private:
-    static const uint32_t PACK_SIGNATURE = 0x5041434B;  // "PACK"
-    static const size_t CHUNK_SIZE = 4096;
+    static constexpr uint32_t PACK_SIGNATURE = 0x5041434B;  // "PACK"
+    static constexpr uint64_t PACK_HEADER_SIZE = 12;
+    static constexpr size_t CHUNK_SIZE = 4096;
+    static constexpr size_t CACHE_SHARDS = 16;
+    // Корней дерева дельт в одной порции пакетного обхода
+    static constexpr size_t BULK_GRAIN = 64;
+    // Предел длины цепочки дельт при спуске по заголовкам
+    static constexpr size_t MAX_DELTA_DEPTH = 10000;
+    // Буферы больше этого после распаковки не остаются в запасе потока
+    static constexpr size_t RETAINED_BUFFER_LIMIT = 16 * 1024 * 1024;
+    // Замер дельт: сколько распакованных баз и дельт держать сразу и сколько
+    // раз накладывать каждую порцию
+    static constexpr size_t BENCHMARK_BATCH_BYTES = 64 * 1024 * 1024;
+    static constexpr int BENCHMARK_ROUNDS = 5;
 
-    std::ifstream packFile;
     std::string packPath;
+    MappedFile pack;
+
+    // Позиция для последовательного чтения через readExactly
+    uint64_t cursor = 0;
+
+    // Кэш не меняет наблюдаемого состояния парсера, поэтому mutable
+    mutable DeltaBaseCache baseCache{DeltaBaseCache::DEFAULT_MEMORY_LIMIT, CACHE_SHARDS};
+
+    // Индекс для поиска баз REF_DELTA по SHA-1
+    const GitIdxParser* index = nullptr;
+
+    // Границы сжатых данных объектов; без него zlib читает до конца потока
+    std::unique_ptr<PackReverseIndex> reverseIndex;
+
+    // Конец сжатых данных, начинающихся с pos
+    uint64_t compressedEnd(uint64_t pos) const;
+
+    // Распаковщик для объектов с известными границами, то есть при обратном индексе
+    Decompressor::Backend decompressorBackend = Decompressor::Backend::ZLIB;
+
+    // Объект в дереве дельт при пакетном обходе
+    struct BulkNode {
+        uint64_t offset;
+        uint64_t baseOffset;
+        uint64_t dataOffset;
+        size_t size;
+        // Номера в списке, переданном в forEachObject, с этим смещением:
+        // order[firstItem, firstItem + itemCount)
+        size_t firstItem;
+        size_t itemCount;
+        GitObjectType type;
+    };
+
+    uint8_t readByteAt(uint64_t& pos) const;
+
+    // Смещение базы REF_DELTA по её SHA-1
+    uint64_t findRefDeltaBase(const unsigned char* baseHash) const;
+
+    // Распаковка не более maxBytes первых байт данных объекта; возвращает их число
+    size_t inflatePrefix(uint64_t pos, size_t expectedSize, uint8_t* output, size_t maxBytes) const;
+
+    // Позиция потоковой распаковки; chunk — буфер для чтения через pread
+    struct InputCursor {
+        uint64_t pos;
+        uint64_t end;
+        bool whole;
+        uint8_t chunk[CHUNK_SIZE];
+    };
+
+    // Очередная порция сжатых данных от pos до end: из отображения (до end
+    // сразу, если whole) или через pread окном CHUNK_SIZE. За end — runtime_error
+    size_t nextInput(InputCursor& cursor, const uint8_t*& data) const;
+
+    // Распаковка expectedSize байт с позиции pos в переиспользуемый буфер
+    void inflateInto(uint64_t pos, size_t expectedSize, std::vector<uint8_t>& output) const;
 
 public:
+    // Размеры объектов в pack файле по типам, как они записаны (дельты отдельно)
+    struct SizeStats {
+        uint64_t objects[8] = {};
+        uint64_t bytes[8] = {};
+        uint64_t largest = 0;
+        uint64_t largestOffset = 0;
+    };
+
+    // Замер распаковки всех объектов pack файла одним распаковщиком
+    struct InflateBenchmark {
+        uint64_t objects = 0;
+        uint64_t compressedBytes = 0;
+        uint64_t inflatedBytes = 0;
+        double seconds = 0;
+    };
+
+    // Замер наложения дельт: базы и дельты распакованы заранее
+    struct DeltaBenchmark {
+        uint64_t deltas = 0;
+        uint64_t deltaBytes = 0;
+        uint64_t resultBytes = 0;
+        // Дельты, которые не удалось подготовить к замеру
+        uint64_t corrupt = 0;
+        double seconds = 0;
+    };
+
+    // Получатель объектов пакетного обхода: номер в списке смещений, тип и содержимое
+    using ObjectVisitor = std::function<void(size_t item, GitObjectType type, const std::vector<uint8_t>& content)>;
+
+    // Последовательное чтение с внутренним курсором, не потокобезопасно
     bool readExactly(char* buffer, size_t size);
 
-    // Чтение переменной длины числа
+    // Чтение переменной длины числа с позиции курсора
     uint64_t readVariableLengthNumber(int& shift);
 
-    // Декодирование сжатых данных zlib
-    std::vector<uint8_t> inflateData(z_stream& zs, size_t expectedSize);
+    // Заголовок объекта без распаковки данных (data остаётся пустым)
+    PackedObject readObjectHeader(uint64_t offset) const;
 
     // Чтение объекта по смещению
-    PackedObject readObjectAtOffset(uint32_t offset);
+    PackedObject readObjectAtOffset(uint64_t offset) const;
+
+    std::vector<uint8_t> applyDelta(const std::vector<uint8_t>& baseData, const std::vector<uint8_t>& deltaData) const;
 
-    std::vector<uint8_t> applyDelta(const std::vector<uint8_t>& baseData, const std::vector<uint8_t>& deltaData);
+    // То же, но результат пишется в готовый буфер, чья ёмкость переиспользуется.
+    // Каждая команда проверяется в Delta::apply
+    static void applyDeltaInto(const std::vector<uint8_t>& baseData, const std::vector<uint8_t>& deltaData,
+                               std::vector<uint8_t>& result);
 
-    GitPackParser(const std::string& packFilePath);
+    // useMmap = false включает чтение через pread
+    GitPackParser(const std::string& packFilePath, bool useMmap = true);
 
     ~GitPackParser();
 
-    std::pair<GitObjectType, std::vector<uint8_t>> getObjectContent(uint32_t offset);
+    // composeDeltas сворачивает цепочку дельт в одну программу от корневой базы
+    // (Delta::compose) и собирает объект за один проход вместо построения
+    // каждой промежуточной версии. Промежуточные базы тогда не кэшируются
+    std::pair<GitObjectType, std::vector<uint8_t>> getObjectContent(uint64_t offset, bool composeDeltas = false) const;
+
+    // То же в буфер вызывающего: результат пишется прямо в него, и при
+    // достаточной ёмкости буфер не перевыделяется. Промежуточные буферы цепочки
+    // дельт и z_stream берутся из запасов потока
+    GitObjectType getObjectContent(uint64_t offset, std::vector<uint8_t>& content, bool composeDeltas = false) const;
+
+    // Тип объекта только по заголовкам, без распаковки. Для дельт это тип
+    // корня цепочки, к которому спускаемся по заголовкам баз
+    GitObjectType peekType(uint64_t offset) const;
+
+    // Размер объекта. Для дельт распаковывается только начало дельты,
+    // где записан размер результата
+    uint64_t peekSize(uint64_t offset) const;
+
+    // Пакетный обход объектов, как в git index-pack: объекты читаются в порядке
+    // смещений, строится дерево база -> дельты, каждая база распаковывается
+    // один раз, и пока она в памяти, к ней применяются все её дельты.
+    // При threads > 1 visit вызывается из нескольких потоков одновременно.
+    // Если задан wantType, деревья дельт с ненужным типом корня пропускаются
+    // целиком: тип дельты всегда совпадает с типом её корня.
+    // Повреждённый объект пропускается вместе с дельтами, построенными на нём,
+    // остальные объекты обходятся как обычно. Возвращает число повреждённых
+    // объектов; пропущенные вместе с ними дельты в нём не учитываются.
+    size_t forEachObject(const std::vector<uint64_t>& offsets, const ObjectVisitor& visit, unsigned threads = 1,
+                       const std::function<bool(GitObjectType)>& wantType = nullptr) const;
 
     static std::string objectTypeToString(GitObjectType type);
+
+    DeltaBaseCache& deltaBaseCache() { return baseCache; }
+
+    const DeltaBaseCache& deltaBaseCache() const { return baseCache; }
+
+    void setIndex(const GitIdxParser* idx) { index = idx; }
+
+    // Обратный индекс из pack-*.rev рядом с pack файлом или построенный по индексу.
+    // После этого каждая распаковка читает ровно сжатые байты своего объекта
+    void loadReverseIndex();
+
+    const PackReverseIndex* reverseIndexOf() const { return reverseIndex.get(); }
+
+    // Точные размеры объектов на диске; нужен обратный индекс
+    SizeStats sizeStatistics() const;
+
+    static void printSizeStats(const SizeStats& stats);
+
+    // Распаковщик для объектов с известными границами; runtime_error, если
+    // библиотека не подключена при сборке
+    void setDecompressor(Decompressor::Backend backend);
+
+    Decompressor::Backend decompressor() const { return decompressorBackend; }
+
+    // Распаковка сжатых данных каждого объекта (дельты не применяются) распаковщиком
+    // backend; нужен обратный индекс
+    InflateBenchmark benchmarkInflate(Decompressor::Backend backend) const;
+
+    static void printInflateBenchmark(Decompressor::Backend backend, const InflateBenchmark& result);
+
+    // Delta::apply на каждой дельте pack файла в переиспользуемый буфер, как
+    // в getObjectContent. Время — сумма лучших из BENCHMARK_ROUNDS проходов по порциям
+    DeltaBenchmark benchmarkDelta() const;
+
+    static void printDeltaBenchmark(const DeltaBenchmark& result);
 };
 
 #endif
@@ -0,0 +1,346 @@
+#include "GraphRenderer.hpp"
+#include "GitIdxParser.hpp"
+#include "PngWriter.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <queue>
+#include <stdexcept>
+#include <unordered_map>
+
+const unsigned char* GraphRenderer::laneColor(size_t column) {
+    static const unsigned char palette[8][3] = {
+        {0x1f, 0x77, 0xb4}, {0xd6, 0x27, 0x28}, {0x2c, 0xa0, 0x2c}, {0xff, 0x7f, 0x0e},
+        {0x94, 0x67, 0xbd}, {0x8c, 0x56, 0x4b}, {0xe3, 0x77, 0xc2}, {0x17, 0xbe, 0xcf}};
+    return palette[column % 8];
+}
+
+GraphLayout GraphRenderer::layout(const std::vector<CommitRecord>& commits) {
+    size_t count = commits.size();
+    std::unordered_map<std::string, size_t> indexOf;
+    indexOf.reserve(count);
+    std::vector<std::string> hex(count);
+    for (size_t i = 0; i < count; i++) {
+        hex[i] = GitIdxParser::bytesToHex(commits[i].id, 20);
+        indexOf.emplace(hex[i], i);
+    }
+
+    // Родители среди коммитов; -1 — родитель за пределами выборки
+    std::vector<std::vector<int64_t>> parents(count);
+    std::vector<size_t> pendingChildren(count, 0);
+    for (size_t i = 0; i < count; i++) {
+        for (const std::string& parent : commits[i].parents) {
+            auto it = indexOf.find(parent);
+            parents[i].push_back(it == indexOf.end() ? -1 : static_cast<int64_t>(it->second));
+            if (it != indexOf.end()) {
+                pendingChildren[it->second]++;
+            }
+        }
+    }
+
+    // Порядок строк как в git log --date-order: коммит идёт после всех своих
+    // детей, среди готовых первым — самый новый
+    auto newer = [&](size_t a, size_t b) {
+        if (commits[a].time != commits[b].time) {
+            return commits[a].time < commits[b].time;
+        }
+        return hex[a] > hex[b];
+    };
+    std::priority_queue<size_t, std::vector<size_t>, decltype(newer)> ready(newer);
+    for (size_t i = 0; i < count; i++) {
+        if (pendingChildren[i] == 0) {
+            ready.push(i);
+        }
+    }
+    std::vector<size_t> order;
+    order.reserve(count);
+    while (!ready.empty()) {
+        size_t i = ready.top();
+        ready.pop();
+        order.push_back(i);
+        for (int64_t parent : parents[i]) {
+            if (parent >= 0 && --pendingChildren[parent] == 0) {
+                ready.push(static_cast<size_t>(parent));
+            }
+        }
+    }
+    if (order.size() != count) {
+        throw std::runtime_error("В графе коммитов есть цикл");
+    }
+
+    std::vector<size_t> rowOf(count);
+    for (size_t row = 0; row < count; row++) {
+        rowOf[order[row]] = row;
+    }
+
+    // Дорожки: колонка закрепляется за коммитом, пока не дойдём до его строки
+    GraphLayout result;
+    result.rows.reserve(count);
+    std::vector<int64_t> laneOf(count, -1);
+    // Дорожки, которые освобождаются на строке коммита, кроме его собственной
+    std::vector<std::vector<size_t>> releaseAt(count);
+    std::priority_queue<size_t, std::vector<size_t>, std::greater<size_t>> freeColumns;
+    auto allocate = [&]() {
+        if (!freeColumns.empty()) {
+            size_t column = freeColumns.top();
+            freeColumns.pop();
+            return column;
+        }
+        return result.width++;
+    };
+
+    for (size_t row = 0; row < count; row++) {
+        size_t i = order[row];
+        size_t column = laneOf[i] >= 0 ? static_cast<size_t>(laneOf[i]) : allocate();
+        result.rows.push_back({i, column});
+        for (size_t lane : releaseAt[i]) {
+            freeColumns.push(lane);
+        }
+
+        bool columnPassed = false;
+        for (size_t k = 0; k < parents[i].size(); k++) {
+            int64_t parent = parents[i][k];
+            if (parent < 0) {
+                result.edges.push_back({row, column, column, -1, column});
+                continue;
+            }
+            size_t lane;
+            if (k == 0 && (laneOf[parent] < 0 || static_cast<size_t>(laneOf[parent]) > column)) {
+                // Первый родитель продолжает колонку коммита, остальные получают новые
+                if (laneOf[parent] >= 0) {
+                    releaseAt[parent].push_back(static_cast<size_t>(laneOf[parent]));
+                }
+                laneOf[parent] = static_cast<int64_t>(column);
+                columnPassed = true;
+                lane = column;
+            } else {
+                if (laneOf[parent] < 0) {
+                    laneOf[parent] = static_cast<int64_t>(allocate());
+                }
+                lane = static_cast<size_t>(laneOf[parent]);
+            }
+            result.edges.push_back({row, column, lane, static_cast<int64_t>(rowOf[parent]), 0});
+        }
+        if (!columnPassed) {
+            freeColumns.push(column);
+        }
+    }
+
+    for (GraphLayout::Edge& edge : result.edges) {
+        if (edge.toRow >= 0) {
+            edge.toColumn = result.rows[edge.toRow].column;
+        }
+    }
+    return result;
+}
+
+void GraphRenderer::writeSvg(const GraphLayout& layout, const std::vector<CommitRecord>& commits,
+                             const std::string& path) {
+    std::ofstream output(path, std::ios::trunc);
+    if (!output) {
+        throw std::runtime_error("Не удалось создать файл " + path);
+    }
+
+    auto x = [](size_t column) { return SVG_COLUMN_WIDTH / 2 + static_cast<int64_t>(column) * SVG_COLUMN_WIDTH; };
+    auto y = [](int64_t row) { return SVG_ROW_HEIGHT / 2 + row * SVG_ROW_HEIGHT; };
+    auto color = [](size_t column) {
+        const unsigned char* c = laneColor(column);
+        char buffer[8];
+        std::snprintf(buffer, sizeof(buffer), "#%02x%02x%02x", c[0], c[1], c[2]);
+        return std::string(buffer);
+    };
+
+    int64_t textX = x(layout.width) + SVG_COLUMN_WIDTH / 2;
+    int64_t width = textX + 41 * 7;
+    int64_t height = static_cast<int64_t>(layout.rows.size()) * SVG_ROW_HEIGHT;
+    output << "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"" << width << "\" height=\"" << height
+           << "\" font-family=\"monospace\" font-size=\"11\">\n";
+
+    // Линии: из вершины по диагонали в дорожку родителя, дальше вниз до него
+    output << "<g fill=\"none\" stroke-width=\"2\">\n";
+    for (const GraphLayout::Edge& edge : layout.edges) {
+        int64_t x0 = x(edge.fromColumn), y0 = y(edge.fromRow);
+        int64_t lane = x(edge.lane);
+        output << "<polyline stroke=\"" << color(edge.lane) << "\"";
+        if (edge.toRow < 0) {
+            // Родитель вне выборки: короткий пунктир вниз
+            output << " stroke-dasharray=\"2,2\" points=\"" << x0 << "," << y0 << " " << lane << ","
+                   << y0 + SVG_ROW_HEIGHT / 2 << "\"/>\n";
+            continue;
+        }
+        output << " points=\"" << x0 << "," << y0;
+        if (edge.toRow > static_cast<int64_t>(edge.fromRow) + 1) {
+            output << " " << lane << "," << y(edge.fromRow + 1);
+        }
+        if (edge.toColumn != edge.lane && edge.toRow > static_cast<int64_t>(edge.fromRow) + 2) {
+            output << " " << lane << "," << y(edge.toRow - 1);
+        }
+        output << " " << x(edge.toColumn) << "," << y(edge.toRow) << "\"/>\n";
+    }
+    output << "</g>\n";
+
+    char sha1[41] = {};
+    for (size_t row = 0; row < layout.rows.size(); row++) {
+        const GraphLayout::Node& node = layout.rows[row];
+        GitIdxParser::bytesToHex(commits[node.commit].id, 20, sha1);
+        output << "<circle cx=\"" << x(node.column) << "\" cy=\"" << y(row) << "\" r=\"" << SVG_RADIUS
+               << "\" fill=\"" << color(node.column) << "\"><title>" << sha1 << "</title></circle>"
+               << "<text x=\"" << textX << "\" y=\"" << y(row) + 4 << "\">" << sha1 << "</text>\n";
+    }
+    output << "</svg>\n";
+    output.close();
+    if (!output) {
+        throw std::runtime_error("Ошибка записи SVG файла");
+    }
+}
+
+namespace {
+
+// Полоса изображения высотой до PNG_BAND_HEIGHT строк, начиная с top
+struct Band {
+    std::vector<unsigned char> pixels;
+    int64_t width;
+    int64_t top;
+    int64_t height;
+
+    void set(int64_t px, int64_t py, const unsigned char* color) {
+        if (px < 0 || px >= width || py < top || py >= top + height) {
+            return;
+        }
+        std::memcpy(&pixels[((py - top) * width + px) * 3], color, 3);
+    }
+
+    // Отрезок толщиной 2 пикселя; перебирается только часть внутри полосы
+    void line(int64_t x0, int64_t y0, int64_t x1, int64_t y1, const unsigned char* color) {
+        int64_t dx = x1 - x0, dy = y1 - y0;
+        if (std::llabs(dy) >= std::llabs(dx)) {
+            if (dy == 0) {
+                set(x0, y0, color);
+                return;
+            }
+            int64_t from = std::max(std::min(y0, y1), top), to = std::min(std::max(y0, y1), top + height - 1);
+            for (int64_t py = from; py <= to; py++) {
+                int64_t px = x0 + (py - y0) * dx / dy;
+                set(px, py, color);
+                set(px + 1, py, color);
+            }
+        } else {
+            for (int64_t px = std::min(x0, x1); px <= std::max(x0, x1); px++) {
+                int64_t py = y0 + (px - x0) * dy / dx;
+                set(px, py, color);
+                set(px, py + 1, color);
+            }
+        }
+    }
+
+    void circle(int64_t cx, int64_t cy, int64_t radius, const unsigned char* color) {
+        for (int64_t oy = -radius; oy <= radius; oy++) {
+            for (int64_t ox = -radius; ox <= radius; ox++) {
+                if (ox * ox + oy * oy <= radius * radius + radius) {
+                    set(cx + ox, cy + oy, color);
+                }
+            }
+        }
+    }
+
+    // Шрифт 3x5 для шестнадцатеричных цифр: по строке на 3 бита
+    void text(int64_t px, int64_t py, const char* hex, size_t length, const unsigned char* color) {
+        static const unsigned char glyphs[16][5] = {
+            {7, 5, 5, 5, 7}, {2, 6, 2, 2, 7}, {7, 1, 7, 4, 7}, {7, 1, 7, 1, 7},
+            {5, 5, 7, 1, 1}, {7, 4, 7, 1, 7}, {7, 4, 7, 5, 7}, {7, 1, 1, 1, 1},
+            {7, 5, 7, 5, 7}, {7, 5, 7, 1, 7}, {2, 5, 7, 5, 5}, {6, 5, 6, 5, 6},
+            {3, 4, 4, 4, 3}, {6, 5, 5, 5, 6}, {7, 4, 6, 4, 7}, {7, 4, 6, 4, 4}};
+        for (size_t i = 0; i < length; i++) {
+            int digit = hex[i] <= '9' ? hex[i] - '0' : hex[i] - 'a' + 10;
+            for (int gy = 0; gy < 5; gy++) {
+                for (int gx = 0; gx < 3; gx++) {
+                    if (glyphs[digit][gy] & (4 >> gx)) {
+                        set(px + static_cast<int64_t>(i) * 4 + gx, py + gy, color);
+                    }
+                }
+            }
+        }
+    }
+};
+
+}
+
+void GraphRenderer::writePng(const GraphLayout& layout, const std::vector<CommitRecord>& commits,
+                             const std::string& path) {
+    auto x = [](size_t column) { return PNG_COLUMN_WIDTH / 2 + static_cast<int64_t>(column) * PNG_COLUMN_WIDTH; };
+    auto y = [](int64_t row) { return PNG_ROW_HEIGHT / 2 + row * PNG_ROW_HEIGHT; };
+
+    const int64_t labelLength = 7;
+    int64_t textX = x(layout.width) + PNG_COLUMN_WIDTH / 2;
+    int64_t width = textX + labelLength * 4 + 2;
+    int64_t height = std::max<int64_t>(1, static_cast<int64_t>(layout.rows.size()) * PNG_ROW_HEIGHT);
+    PngWriter png(path, static_cast<uint32_t>(width), static_cast<uint32_t>(height));
+
+    // Отрезки всех линий по возрастанию верхней точки
+    struct Segment {
+        int64_t x0, y0, x1, y1;
+        size_t lane;
+    };
+    std::vector<Segment> segments;
+    segments.reserve(layout.edges.size() * 2);
+    for (const GraphLayout::Edge& edge : layout.edges) {
+        int64_t x0 = x(edge.fromColumn), y0 = y(edge.fromRow), lane = x(edge.lane);
+        if (edge.toRow < 0) {
+            segments.push_back({x0, y0, lane, y0 + PNG_ROW_HEIGHT / 2, edge.lane});
+            continue;
+        }
+        // Те же точки ломаной, что и в SVG
+        std::vector<std::pair<int64_t, int64_t>> points = {{x0, y0}};
+        if (edge.toRow > static_cast<int64_t>(edge.fromRow) + 1) {
+            points.push_back({lane, y(edge.fromRow + 1)});
+        }
+        if (edge.toColumn != edge.lane && edge.toRow > static_cast<int64_t>(edge.fromRow) + 2) {
+            points.push_back({lane, y(edge.toRow - 1)});
+        }
+        points.push_back({x(edge.toColumn), y(edge.toRow)});
+        for (size_t k = 1; k < points.size(); k++) {
+            segments.push_back({points[k - 1].first, points[k - 1].second, points[k].first, points[k].second,
+                                edge.lane});
+        }
+    }
+    std::sort(segments.begin(), segments.end(), [](const Segment& a, const Segment& b) { return a.y0 < b.y0; });
+
+    // Рисуем полосами: в памяти только текущая полоса и отрезки, которые её пересекают
+    static const unsigned char textColor[3] = {0x30, 0x30, 0x30};
+    Band band;
+    band.width = width;
+    std::vector<const Segment*> active;
+    size_t nextSegment = 0;
+    char sha1[41] = {};
+    for (int64_t top = 0; top < height; top += PNG_BAND_HEIGHT) {
+        band.top = top;
+        band.height = std::min<int64_t>(PNG_BAND_HEIGHT, height - top);
+        band.pixels.assign(static_cast<size_t>(band.width * band.height * 3), 0xFF);
+
+        while (nextSegment < segments.size() && segments[nextSegment].y0 < top + band.height) {
+            active.push_back(&segments[nextSegment++]);
+        }
+        active.erase(std::remove_if(active.begin(), active.end(), [&](const Segment* s) {
+            return std::max(s->y0, s->y1) + 1 < top;
+        }), active.end());
+        for (const Segment* s : active) {
+            band.line(s->x0, s->y0, s->x1, s->y1, laneColor(s->lane));
+        }
+
+        // Вершины и подписи строк, которые задевают полосу
+        int64_t firstRow = std::max<int64_t>(0, (top - PNG_ROW_HEIGHT) / PNG_ROW_HEIGHT);
+        int64_t lastRow = std::min<int64_t>(layout.rows.size(), (top + band.height) / PNG_ROW_HEIGHT + 2);
+        for (int64_t row = firstRow; row < lastRow; row++) {
+            const GraphLayout::Node& node = layout.rows[row];
+            band.circle(x(node.column), y(row), PNG_RADIUS, laneColor(node.column));
+            GitIdxParser::bytesToHex(commits[node.commit].id, 20, sha1);
+            band.text(textX, y(row) - 2, sha1, labelLength, textColor);
+        }
+
+        png.writeRows(band.pixels.data(), static_cast<uint32_t>(band.height));
+    }
+    png.finish();
+}
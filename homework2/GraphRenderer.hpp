@@ -0,0 +1,62 @@
+#include <string>
+#include <vector>
+#include "CommitRecord.hpp"
+
+#ifndef GRAPHRENDERER_HPP
+#define GRAPHRENDERER_HPP
+
+// Раскладка графа коммитов по дорожкам, как в git log --graph: одна строка на
+// коммит, дети выше родителей, цепочка первых родителей идёт по одной колонке.
+// Колонка за родителем закрепляется, пока до него не дойдёт очередь, поэтому
+// линии не пересекают чужие вершины. Если первый родитель уже получил колонку
+// правее через слияние, он переезжает в колонку ребёнка, а старая дорожка
+// доводится до его строки и сходится к нему.
+struct GraphLayout {
+    struct Node {
+        size_t commit;  // номер в исходном векторе коммитов
+        size_t column;
+    };
+
+    struct Edge {
+        size_t fromRow;
+        size_t fromColumn;
+        size_t lane;      // колонка, по которой линия идёт вниз к родителю
+        int64_t toRow;    // -1, если родителя нет среди коммитов
+        size_t toColumn;  // колонка родителя; если не lane, линия сходится к нему в последней строке
+    };
+
+    std::vector<Node> rows;
+    std::vector<Edge> edges;
+    size_t width = 0;
+};
+
+// Построение раскладки и вывод в SVG или PNG без внешних программ.
+// Время работы линейно по числу коммитов с точностью до логарифма
+// от очередей дат и свободных колонок.
+class GraphRenderer {
+private:
+    // Размеры в SVG
+    static constexpr int SVG_ROW_HEIGHT = 20;
+    static constexpr int SVG_COLUMN_WIDTH = 14;
+    static constexpr int SVG_RADIUS = 4;
+
+    // Размеры в PNG: мельче, чтобы десятки тысяч коммитов оставались обозримыми
+    static constexpr int PNG_ROW_HEIGHT = 10;
+    static constexpr int PNG_COLUMN_WIDTH = 10;
+    static constexpr int PNG_RADIUS = 3;
+    // Строк изображения, которые рисуются за раз
+    static constexpr int PNG_BAND_HEIGHT = 256;
+
+    // Цвет дорожки по номеру колонки
+    static const unsigned char* laneColor(size_t column);
+
+public:
+    static GraphLayout layout(const std::vector<CommitRecord>& commits);
+
+    static void writeSvg(const GraphLayout& layout, const std::vector<CommitRecord>& commits, const std::string& path);
+
+    // Подписи — первые 7 символов SHA-1, встроенным пиксельным шрифтом
+    static void writePng(const GraphLayout& layout, const std::vector<CommitRecord>& commits, const std::string& path);
+};
+
+#endif
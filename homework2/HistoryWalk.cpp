@@ -0,0 +1,199 @@
+#include "HistoryWalk.hpp"
+#include "CommitHeader.hpp"
+#include "GitIdxParser.hpp"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <queue>
+#include <set>
+
+HistoryWalk::HistoryWalk(std::vector<const ObjectStore*> stores, const CommitGraph* graph)
+    : stores(std::move(stores)), graph(graph) {}
+
+// Первая строка файла без перевода строки
+static std::string readFirstLine(const std::filesystem::path& path) {
+    std::ifstream file(path);
+    std::string line;
+    std::getline(file, line);
+    while (!line.empty() && (line.back() == '\r' || line.back() == ' ')) {
+        line.pop_back();
+    }
+    return line;
+}
+
+std::vector<HistoryWalk::ObjectId> HistoryWalk::readRefs(const std::string& gitDir) {
+    std::filesystem::path root(gitDir);
+    // Имя ссылки -> значение: 40 hex-символов или "ref: <имя>"
+    std::map<std::string, std::string> refs;
+
+    // packed-refs: "<sha1> <имя>", за тегом может идти "^<sha1>" — коммит, на который он указывает
+    std::ifstream packed(root / "packed-refs");
+    std::string line, lastName;
+    while (std::getline(packed, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        if (line[0] == '^') {
+            if (!lastName.empty()) {
+                refs[lastName] = line.substr(1, 40);
+            }
+            continue;
+        }
+        if (line.size() > 41 && line[40] == ' ') {
+            lastName = line.substr(41);
+            refs[lastName] = line.substr(0, 40);
+        }
+    }
+
+    // Отдельные файлы в refs/ новее packed-refs
+    std::error_code ec;
+    if (std::filesystem::is_directory(root / "refs")) {
+        for (auto it = std::filesystem::recursive_directory_iterator(root / "refs", ec);
+             it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+            if (ec) {
+                break;
+            }
+            if (it->is_regular_file()) {
+                std::string name = std::filesystem::relative(it->path(), root).generic_string();
+                refs[name] = readFirstLine(it->path());
+            }
+        }
+    }
+    if (std::filesystem::exists(root / "HEAD")) {
+        refs["HEAD"] = readFirstLine(root / "HEAD");
+    }
+
+    std::set<ObjectId> tips;
+    for (const auto& ref : refs) {
+        std::string value = ref.second;
+        for (int depth = 0; depth < MAX_INDIRECTION && value.compare(0, 5, "ref: ") == 0; depth++) {
+            auto target = refs.find(value.substr(5));
+            value = target == refs.end() ? "" : target->second;
+        }
+        ObjectId id;
+        if (GitIdxParser::hexToBytes(value, id.data())) {
+            tips.insert(id);
+        }
+    }
+    return std::vector<ObjectId>(tips.begin(), tips.end());
+}
+
+bool HistoryWalk::readObject(const ObjectId& id, GitObjectType& type, std::vector<uint8_t>& content) const {
+    for (const ObjectStore* store : stores) {
+        if (store->readObject(id.data(), type, content)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool HistoryWalk::loadCommit(const ObjectId& id, CommitInfo& info) const {
+    if (graph) {
+        int64_t pos = graph->findCommit(id.data());
+        if (pos >= 0) {
+            info.time = static_cast<int64_t>(graph->commitTimeAt(pos));
+            std::vector<uint64_t> parents;
+            graph->parentsAt(pos, parents);
+            info.parents.resize(parents.size());
+            for (size_t k = 0; k < parents.size(); k++) {
+                std::memcpy(info.parents[k].data(), graph->sha1At(parents[k]), 20);
+            }
+            return true;
+        }
+    }
+
+    GitObjectType type;
+    std::vector<uint8_t> content;
+    CommitHeader header;
+    if (!readObject(id, type, content) || type != GitObjectType::COMMIT ||
+        !CommitHeader::parse(std::string_view(reinterpret_cast<const char*>(content.data()), content.size()), header)) {
+        return false;
+    }
+    info.time = header.committer.time;
+    info.parents.resize(header.parentCount());
+    for (size_t k = 0; k < header.parentCount(); k++) {
+        GitIdxParser::hexToBytes(header.parent(k), info.parents[k].data());
+    }
+    return true;
+}
+
+bool HistoryWalk::peelToCommit(ObjectId& id) const {
+    // Коммиты из commit-graph распаковывать не нужно
+    if (graph && graph->findCommit(id.data()) >= 0) {
+        return true;
+    }
+
+    GitObjectType type;
+    std::vector<uint8_t> content;
+    for (int depth = 0; depth < MAX_INDIRECTION; depth++) {
+        if (!readObject(id, type, content)) {
+            return false;
+        }
+        if (type == GitObjectType::COMMIT) {
+            return true;
+        }
+        // Тег начинается со строки "object <sha1>"
+        if (type != GitObjectType::TAG || content.size() < 47 || std::memcmp(content.data(), "object ", 7) != 0 ||
+            !GitIdxParser::hexToBytes(std::string_view(reinterpret_cast<const char*>(content.data()) + 7, 40),
+                                      id.data())) {
+            return false;
+        }
+    }
+    return false;
+}
+
+std::vector<CommitRecord> HistoryWalk::collectCommits(const std::vector<ObjectId>& tips, const int& from,
+                                                      size_t* visited) const {
+    // Очередь по дате, самые новые сверху
+    using Entry = std::pair<int64_t, ObjectId>;
+    std::priority_queue<Entry> frontier;
+    std::map<ObjectId, CommitInfo> loaded;
+    std::set<ObjectId> queued;
+    size_t reads = 0;
+
+    auto push = [&](const ObjectId& id) {
+        if (!queued.insert(id).second) {
+            return;
+        }
+        reads++;
+        CommitInfo info;
+        if (loadCommit(id, info)) {
+            frontier.push({info.time, id});
+            loaded.emplace(id, std::move(info));
+        }
+    };
+
+    for (ObjectId tip : tips) {
+        if (peelToCommit(tip)) {
+            push(tip);
+        }
+    }
+
+    std::vector<CommitRecord> commits;
+    while (!frontier.empty() && frontier.top().first >= from) {
+        ObjectId id = frontier.top().second;
+        frontier.pop();
+        const CommitInfo& info = loaded.at(id);
+
+        CommitRecord record;
+        std::memcpy(record.id, id.data(), 20);
+        record.time = static_cast<int>(info.time);
+        for (const ObjectId& parent : info.parents) {
+            record.parents.push_back(GitIdxParser::bytesToHex(parent.data(), 20));
+        }
+        commits.push_back(std::move(record));
+
+        for (const ObjectId& parent : info.parents) {
+            push(parent);
+        }
+        loaded.erase(id);
+    }
+
+    if (visited) {
+        *visited = reads;
+    }
+    GitIdxParser::sortUniqueCommits(commits);
+    return commits;
+}
@@ -0,0 +1,55 @@
+#include <array>
+#include <string>
+#include <vector>
+#include "CommitGraph.hpp"
+#include "CommitRecord.hpp"
+#include "ObjectStore.hpp"
+
+#ifndef HISTORYWALK_HPP
+#define HISTORYWALK_HPP
+
+// Обход истории от ссылок репозитория: HEAD, refs/ и packed-refs. Коммиты
+// достаются из очереди с приоритетом по дате коммитера, самые новые первыми;
+// как только самый новый коммит очереди старше границы, старше и все остальные,
+// и обход заканчивается. Стоимость зависит от размера окна по дате, а не
+// от размера репозитория. Коммит с датой новее границы, до которого можно
+// дойти только через более старый (сбитые часы), в окно не попадёт.
+class HistoryWalk {
+public:
+    using ObjectId = std::array<unsigned char, 20>;
+
+private:
+    // Вложенность символьных ссылок и аннотированных тегов
+    static constexpr int MAX_INDIRECTION = 10;
+
+    std::vector<const ObjectStore*> stores;
+    const CommitGraph* graph;
+
+    struct CommitInfo {
+        int64_t time = 0;
+        std::vector<ObjectId> parents;
+    };
+
+    bool readObject(const ObjectId& id, GitObjectType& type, std::vector<uint8_t>& content) const;
+
+    // Дата и родители: из commit-graph, если он покрывает коммит, иначе распаковкой
+    bool loadCommit(const ObjectId& id, CommitInfo& info) const;
+
+    // Снятие аннотированных тегов; false, если ссылка ведёт не на коммит
+    bool peelToCommit(ObjectId& id) const;
+
+public:
+    // stores опрашиваются по порядку; graph может быть nullptr
+    explicit HistoryWalk(std::vector<const ObjectStore*> stores, const CommitGraph* graph = nullptr);
+
+    // Значения всех ссылок каталога .git; символьные ссылки разыменовываются,
+    // повторы убираются. Теги не снимаются, кроме строк ^ из packed-refs
+    static std::vector<ObjectId> readRefs(const std::string& gitDir);
+
+    // Коммиты с датой не раньше from, достижимые из tips, в порядке SHA-1.
+    // visited — сколько коммитов пришлось прочитать
+    std::vector<CommitRecord> collectCommits(const std::vector<ObjectId>& tips, const int& from,
+                                             size_t* visited = nullptr) const;
+};
+
+#endif
@@ -0,0 +1,275 @@
+#include "LooseObjectStore.hpp"
+#include "CommitCache.hpp"
+#include "MappedFile.hpp"
+#include "ParallelFor.hpp"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <stdexcept>
+#include <zlib.h>
+
+LooseObjectStore::LooseObjectStore(const std::string& objectsDir) : objectsDir(objectsDir) {}
+
+std::string LooseObjectStore::objectPath(const unsigned char* sha1) const {
+    char hex[41] = {};
+    GitIdxParser::bytesToHex(sha1, 20, hex);
+    std::string path = objectsDir;
+    path += '/';
+    path.append(hex, 2);
+    path += '/';
+    path.append(hex + 2, 38);
+    return path;
+}
+
+std::vector<LooseObjectStore::ObjectId> LooseObjectStore::listObjects(unsigned threads) const {
+    threads = resolveThreadCount(threads);
+    std::vector<std::vector<ObjectId>> found(threads);
+
+    parallelFor(256, threads, 1, [&](unsigned worker, size_t begin, size_t end) {
+        static const char digits[] = "0123456789abcdef";
+        for (size_t b = begin; b < end; b++) {
+            char dirName[3] = {digits[b >> 4], digits[b & 0xF], 0};
+            std::error_code ec;
+            std::filesystem::directory_iterator it(std::filesystem::path(objectsDir) / dirName, ec);
+            if (ec) {
+                continue;
+            }
+
+            for (const auto& entry : it) {
+                // Имя файла — оставшиеся 38 hex-символов; временные файлы git пропускаем
+                std::string name = entry.path().filename().string();
+                ObjectId id;
+                if (name.size() != 38 || !GitIdxParser::hexToBytes(dirName + name, id.data())) {
+                    continue;
+                }
+                found[worker].push_back(id);
+            }
+        }
+    });
+
+    std::vector<ObjectId> ids;
+    for (std::vector<ObjectId>& part : found) {
+        ids.insert(ids.end(), part.begin(), part.end());
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+bool LooseObjectStore::readCompressed(const unsigned char* sha1, std::vector<uint8_t>& compressed) const {
+    std::string path = objectPath(sha1);
+    if (!std::filesystem::exists(path)) {
+        return false;
+    }
+
+    // Файлы маленькие: pread дешевле, чем отображение в память
+    MappedFile file(path, false);
+    compressed.resize(file.size());
+    // Файл, укороченный после открытия, даёт неполное чтение, а не мусор для zlib
+    return file.readAt(0, compressed.data(), compressed.size());
+}
+
+void LooseObjectStore::inflateLoose(const std::vector<uint8_t>& compressed, std::vector<uint8_t>& out,
+                                    size_t maxBytes) {
+    z_stream zs;
+    std::memset(&zs, 0, sizeof(zs));
+    if (inflateInit(&zs) != Z_OK) {
+        throw std::runtime_error("Не удалось инициализировать zlib");
+    }
+
+    zs.next_in = const_cast<Bytef*>(compressed.data());
+    zs.avail_in = static_cast<uInt>(compressed.size());
+
+    // Размер содержимого заранее неизвестен: растим буфер, пока поток не кончится
+    out.resize(maxBytes ? maxBytes : std::max<size_t>(compressed.size() * 2, HEADER_PREFIX_SIZE));
+    size_t produced = 0;
+    int ret = Z_OK;
+    while (ret != Z_STREAM_END) {
+        if (produced == out.size()) {
+            if (maxBytes) {
+                break;
+            }
+            out.resize(out.size() * 2);
+        }
+        zs.next_out = out.data() + produced;
+        zs.avail_out = static_cast<uInt>(out.size() - produced);
+        ret = inflate(&zs, Z_NO_FLUSH);
+        produced = out.size() - zs.avail_out;
+        if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
+            inflateEnd(&zs);
+            throw std::runtime_error("Ошибка распаковки отдельного объекта");
+        }
+        // Вход кончился, а место для вывода ещё есть — поток обрезан
+        if (ret == Z_BUF_ERROR && zs.avail_out > 0) {
+            break;
+        }
+    }
+    inflateEnd(&zs);
+
+    if (!maxBytes && ret != Z_STREAM_END) {
+        throw std::runtime_error("Отдельный объект обрезан");
+    }
+    out.resize(produced);
+}
+
+size_t LooseObjectStore::parseHeader(const std::vector<uint8_t>& data, GitObjectType& type, uint64_t& size) {
+    const uint8_t* end = static_cast<const uint8_t*>(std::memchr(data.data(), 0, data.size()));
+    const uint8_t* space = static_cast<const uint8_t*>(std::memchr(data.data(), ' ', data.size()));
+    if (!end || !space || space > end) {
+        throw std::runtime_error("Некорректный заголовок отдельного объекта");
+    }
+
+    std::string name(data.data(), space);
+    if (name == "commit") {
+        type = GitObjectType::COMMIT;
+    } else if (name == "tree") {
+        type = GitObjectType::TREE;
+    } else if (name == "blob") {
+        type = GitObjectType::BLOB;
+    } else if (name == "tag") {
+        type = GitObjectType::TAG;
+    } else {
+        throw std::runtime_error("Неизвестный тип отдельного объекта: " + name);
+    }
+
+    size = 0;
+    for (const uint8_t* p = space + 1; p < end; p++) {
+        if (*p < '0' || *p > '9') {
+            throw std::runtime_error("Некорректный размер отдельного объекта");
+        }
+        size = size * 10 + (*p - '0');
+    }
+    return end - data.data() + 1;
+}
+
+bool LooseObjectStore::contains(const unsigned char* sha1) const {
+    return std::filesystem::exists(objectPath(sha1));
+}
+
+void LooseObjectStore::decode(const std::vector<uint8_t>& compressed, GitObjectType& type, std::vector<uint8_t>& content) {
+    inflateLoose(compressed, content, 0);
+
+    uint64_t size;
+    size_t headerSize = parseHeader(content, type, size);
+    if (content.size() - headerSize != size) {
+        throw std::runtime_error("Размер отдельного объекта не совпадает с заголовком");
+    }
+    content.erase(content.begin(), content.begin() + headerSize);
+}
+
+bool LooseObjectStore::readObject(const unsigned char* sha1, GitObjectType& type, std::vector<uint8_t>& content) const {
+    std::vector<uint8_t> compressed;
+    if (!readCompressed(sha1, compressed)) {
+        return false;
+    }
+    decode(compressed, type, content);
+    return true;
+}
+
+bool LooseObjectStore::peekType(const unsigned char* sha1, GitObjectType& type) const {
+    std::vector<uint8_t> compressed;
+    if (!readCompressed(sha1, compressed)) {
+        return false;
+    }
+    std::vector<uint8_t> prefix;
+    inflateLoose(compressed, prefix, HEADER_PREFIX_SIZE);
+
+    uint64_t size;
+    parseHeader(prefix, type, size);
+    return true;
+}
+
+std::vector<CommitRecord> LooseObjectStore::collectCommits(const int& from, const ExtractOptions& options) const {
+    unsigned threads = resolveThreadCount(options.threads);
+    std::vector<ObjectId> ids = listObjects(threads);
+
+    // Объекты, разобранные прошлыми запусками, повторно не распаковываются;
+    // с кэшем коммиты разбираются без отбора по дате
+    CommitCache* cache = options.resultCache;
+    const int decodeFrom = cache ? std::numeric_limits<int>::min() : from;
+    std::vector<ObjectId> cachedSeen;
+    std::vector<CommitRecord> cachedCommits;
+    if (cache && !cache->loadLoose(cachedSeen, cachedCommits)) {
+        cachedSeen.clear();
+        cachedCommits.clear();
+    }
+    auto isCachedCommit = [&](const ObjectId& id) {
+        auto it = std::lower_bound(cachedCommits.begin(), cachedCommits.end(), id,
+                                   [](const CommitRecord& record, const ObjectId& key) {
+                                       return std::memcmp(record.id, key.data(), 20) < 0;
+                                   });
+        return it != cachedCommits.end() && std::memcmp(it->id, id.data(), 20) == 0;
+    };
+
+    std::vector<ObjectId> pending;
+    std::vector<ObjectId> seen;
+    std::vector<CommitRecord> commits;
+    for (const ObjectId& id : ids) {
+        if (isCachedCommit(id)) {
+            continue;
+        }
+        if (std::binary_search(cachedSeen.begin(), cachedSeen.end(), id)) {
+            seen.push_back(id);
+        } else {
+            pending.push_back(id);
+        }
+    }
+    // Коммиты, которых больше нет среди отдельных объектов (их упаковал git gc), забываем
+    for (CommitRecord& record : cachedCommits) {
+        ObjectId id;
+        std::memcpy(id.data(), record.id, 20);
+        if (std::binary_search(ids.begin(), ids.end(), id)) {
+            commits.push_back(std::move(record));
+        }
+    }
+    if (cache) {
+        cache->looseStats.hits += ids.size() - pending.size();
+        cache->looseStats.misses += pending.size();
+    }
+
+    std::vector<std::vector<CommitRecord>> found(threads);
+    std::vector<std::vector<ObjectId>> skipped(threads);
+    parallelFor(pending.size(), threads, INFLATE_GRAIN, [&](unsigned worker, size_t begin, size_t end) {
+        GitObjectType type;
+        uint64_t size;
+        std::vector<uint8_t> compressed, content;
+        CommitRecord record;
+        for (size_t i = begin; i < end; i++) {
+            try {
+                if (GitIdxParser::takeFromGraph(options, pending[i].data(), decodeFrom, found[worker])) {
+                    continue;
+                }
+                // Файл читается один раз; деревья и блобы распаковываем только до заголовка
+                if (!readCompressed(pending[i].data(), compressed)) {
+                    continue;
+                }
+                inflateLoose(compressed, content, HEADER_PREFIX_SIZE);
+                parseHeader(content, type, size);
+                if (type != GitObjectType::COMMIT) {
+                    skipped[worker].push_back(pending[i]);
+                    continue;
+                }
+                decode(compressed, type, content);
+                if (GitIdxParser::parseCommitObject(pending[i].data(), type, content, decodeFrom, record)) {
+                    found[worker].push_back(record);
+                }
+            } catch (const std::exception& e) {
+
+            }
+        }
+    });
+
+    for (std::vector<CommitRecord>& part : found) {
+        commits.insert(commits.end(), std::make_move_iterator(part.begin()), std::make_move_iterator(part.end()));
+    }
+    GitIdxParser::sortUniqueCommits(commits);
+    if (cache) {
+        for (std::vector<ObjectId>& part : skipped) {
+            seen.insert(seen.end(), part.begin(), part.end());
+        }
+        std::sort(seen.begin(), seen.end());
+        cache->storeLoose(seen, commits);
+        CommitCache::dropOlder(commits, from);
+    }
+    return commits;
+}
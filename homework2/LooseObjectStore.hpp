@@ -0,0 +1,58 @@
+#include <array>
+#include <string>
+#include <vector>
+#include "CommitRecord.hpp"
+#include "GitIdxParser.hpp"
+#include "ObjectStore.hpp"
+
+#ifndef LOOSEOBJECTSTORE_HPP
+#define LOOSEOBJECTSTORE_HPP
+
+// Отдельные (loose) объекты из .git/objects/xx/yyyy...: каждый файл — это
+// zlib поток "<тип> <размер>\0<содержимое>". Так лежат свежие коммиты,
+// пока git gc не сложил их в pack файл. Чтение объектов потокобезопасно.
+class LooseObjectStore : public ObjectStore {
+private:
+    // Объектов в одной порции параллельной распаковки
+    static constexpr size_t INFLATE_GRAIN = 16;
+    // Заголовок объекта короче: самый длинный — "commit " и 20 цифр размера
+    static constexpr size_t HEADER_PREFIX_SIZE = 32;
+
+    std::string objectsDir;
+
+    std::string objectPath(const unsigned char* sha1) const;
+
+    // Сжатые байты файла объекта; false, если файла нет или он не прочитался целиком
+    bool readCompressed(const unsigned char* sha1, std::vector<uint8_t>& compressed) const;
+
+    // Распаковка не больше maxBytes байт потока (0 — весь поток)
+    static void inflateLoose(const std::vector<uint8_t>& compressed, std::vector<uint8_t>& out, size_t maxBytes);
+
+    // Разбор заголовка; возвращает длину заголовка вместе с нулевым байтом
+    static size_t parseHeader(const std::vector<uint8_t>& data, GitObjectType& type, uint64_t& size);
+
+    // Полная распаковка с проверкой размера из заголовка; в content — только содержимое
+    static void decode(const std::vector<uint8_t>& compressed, GitObjectType& type, std::vector<uint8_t>& content);
+
+public:
+    using ObjectId = std::array<unsigned char, 20>;
+
+    // objectsDir — каталог .git/objects
+    explicit LooseObjectStore(const std::string& objectsDir);
+
+    // Все отдельные объекты в порядке SHA-1; каталоги 00..ff читаются параллельно
+    std::vector<ObjectId> listObjects(unsigned threads = 1) const;
+
+    bool contains(const unsigned char* sha1) const override;
+
+    bool readObject(const unsigned char* sha1, GitObjectType& type, std::vector<uint8_t>& content) const override;
+
+    // Тип объекта; распаковывается только начало потока с заголовком
+    bool peekType(const unsigned char* sha1, GitObjectType& type) const;
+
+    // Коммиты не старше from в порядке SHA-1; распаковка идёт на options.threads потоках.
+    // С options.resultCache распаковываются только объекты, которых нет в кэше
+    std::vector<CommitRecord> collectCommits(const int& from, const ExtractOptions& options = {}) const;
+};
+
+#endif
@@ -0,0 +1,71 @@
+#include "MappedFile.hpp"
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const std::string& path, bool useMmap) {
+    fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Не удалось открыть файл " + path);
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Не удалось получить размер файла " + path);
+    }
+    fileSize = static_cast<uint64_t>(st.st_size);
+
+    // Пустой файл отобразить нельзя, для него остаётся pread
+    if (useMmap && fileSize > 0) {
+        void* addr = ::mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr != MAP_FAILED) {
+            mapped = static_cast<const uint8_t*>(addr);
+        }
+    }
+}
+
+MappedFile::~MappedFile() {
+    if (mapped) {
+        ::munmap(const_cast<uint8_t*>(mapped), fileSize);
+    }
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+
+bool MappedFile::readAt(uint64_t offset, void* buffer, size_t size) const {
+    if (offset > fileSize || size > fileSize - offset) {
+        return false;
+    }
+    if (mapped) {
+        std::memcpy(buffer, mapped + offset, size);
+        return true;
+    }
+
+    char* out = static_cast<char*>(buffer);
+    while (size > 0) {
+        ssize_t n = ::pread(fd, out, size, static_cast<off_t>(offset));
+        if (n <= 0) {
+            return false;
+        }
+        out += n;
+        offset += n;
+        size -= n;
+    }
+    return true;
+}
+
+const uint8_t* MappedFile::view(uint64_t offset, size_t size, std::vector<uint8_t>& scratch) const {
+    if (offset > fileSize || size > fileSize - offset) {
+        return nullptr;
+    }
+    if (mapped) {
+        return mapped + offset;
+    }
+    scratch.resize(size);
+    return readAt(offset, scratch.data(), size) ? scratch.data() : nullptr;
+}
@@ -0,0 +1,39 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+// Файл, отображённый в память целиком. Если mmap недоступен,
+// байты читаются через pread по явному смещению.
+class MappedFile {
+private:
+    int fd = -1;
+    const uint8_t* mapped = nullptr;
+    uint64_t fileSize = 0;
+
+public:
+    explicit MappedFile(const std::string& path, bool useMmap = true);
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    uint64_t size() const { return fileSize; }
+
+    bool isMapped() const { return mapped != nullptr; }
+
+    // Указатель на начало отображения (nullptr без mmap)
+    const uint8_t* data() const { return mapped; }
+
+    // Копирование size байт с позиции offset
+    bool readAt(uint64_t offset, void* buffer, size_t size) const;
+
+    // Указатель на байты [offset, offset + size): прямо в отображение,
+    // а без mmap — в scratch, куда они предварительно прочитаны
+    const uint8_t* view(uint64_t offset, size_t size, std::vector<uint8_t>& scratch) const;
+};
+
+#endif
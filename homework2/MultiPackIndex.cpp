@@ -0,0 +1,151 @@
+#include "MultiPackIndex.hpp"
+#include <iostream>
+#include <stdexcept>
+
+bool MultiPackIndex::mapFile(const std::string& filename) {
+    mapped.reset();
+    packNames.clear();
+    numObjects = 0;
+    oidTable = nullptr;
+    offsetTable = nullptr;
+    largeOffsetTable = nullptr;
+    largeOffsetCount = 0;
+
+    std::unique_ptr<MappedFile> file;
+    try {
+        file = std::make_unique<MappedFile>(filename);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return false;
+    }
+    if (!file->isMapped() || file->size() < MIDX_HEADER_SIZE + 20) {
+        std::cerr << "Не удалось отобразить multi-pack-index: " << filename << std::endl;
+        return false;
+    }
+
+    const unsigned char* data = file->data();
+    uint64_t size = file->size();
+
+    // Заголовок: сигнатура, версия, версия хеша, число блоков, число базовых файлов, число pack файлов
+    if (readBigEndian32(data) != MIDX_SIGNATURE) {
+        std::cerr << "Неверная сигнатура multi-pack-index" << std::endl;
+        return false;
+    }
+    if (data[4] != 1 && data[4] != 2) {
+        std::cerr << "Неподдерживаемая версия multi-pack-index: " << int(data[4]) << std::endl;
+        return false;
+    }
+    if (data[5] != 1) {
+        std::cerr << "Поддерживается только SHA-1 multi-pack-index" << std::endl;
+        return false;
+    }
+    uint32_t chunkCount = data[6];
+    uint32_t packCount = readBigEndian32(data + 8);
+
+    // Таблица блоков: (chunkCount + 1) записей из id и 64-битного смещения
+    if (MIDX_HEADER_SIZE + (chunkCount + 1) * 12 > size) {
+        std::cerr << "multi-pack-index обрезан" << std::endl;
+        return false;
+    }
+    const unsigned char* names = nullptr;
+    const unsigned char* namesEnd = nullptr;
+    const unsigned char* fanoutTable = nullptr;
+    // Размеры блоков: таблицы проверяются по границам своего блока, а не файла
+    uint64_t oidSize = 0;
+    uint64_t offsetSize = 0;
+    for (uint32_t i = 0; i < chunkCount; i++) {
+        const unsigned char* entry = data + MIDX_HEADER_SIZE + i * 12;
+        uint32_t id = readBigEndian32(entry);
+        uint64_t begin = (uint64_t(readBigEndian32(entry + 4)) << 32) | readBigEndian32(entry + 8);
+        uint64_t end = (uint64_t(readBigEndian32(entry + 16)) << 32) | readBigEndian32(entry + 20);
+        if (begin > end || end > size - 20) {
+            std::cerr << "Некорректная таблица блоков multi-pack-index" << std::endl;
+            return false;
+        }
+
+        if (id == CHUNK_PACK_NAMES) {
+            names = data + begin;
+            namesEnd = data + end;
+        } else if (id == CHUNK_OID_FANOUT && end - begin == 256 * 4) {
+            fanoutTable = data + begin;
+        } else if (id == CHUNK_OID_LOOKUP) {
+            oidTable = data + begin;
+            oidSize = end - begin;
+        } else if (id == CHUNK_OBJECT_OFFSETS) {
+            offsetTable = data + begin;
+            offsetSize = end - begin;
+        } else if (id == CHUNK_LARGE_OFFSETS) {
+            largeOffsetTable = data + begin;
+            largeOffsetCount = (end - begin) / 8;
+        }
+    }
+    if (!names || !fanoutTable || !oidTable || !offsetTable) {
+        std::cerr << "В multi-pack-index нет обязательных блоков" << std::endl;
+        return false;
+    }
+
+    // Имена pack файлов: строки с нулём в конце, после них — выравнивание нулями
+    const unsigned char* p = names;
+    while (packNames.size() < packCount && p < namesEnd) {
+        const unsigned char* end = static_cast<const unsigned char*>(std::memchr(p, 0, namesEnd - p));
+        if (!end) {
+            break;
+        }
+        packNames.emplace_back(reinterpret_cast<const char*>(p), end - p);
+        p = end + 1;
+    }
+    if (packNames.size() != packCount) {
+        std::cerr << "Некорректный список pack файлов в multi-pack-index" << std::endl;
+        return false;
+    }
+
+    for (int i = 0; i < 256; i++) {
+        fanout[i] = readBigEndian32(fanoutTable + i * 4);
+        if (i > 0 && fanout[i] < fanout[i - 1]) {
+            std::cerr << "Fanout таблица multi-pack-index не монотонна" << std::endl;
+            return false;
+        }
+    }
+    uint64_t count = fanout[255];
+    if (count * 20 > oidSize || count * 8 > offsetSize) {
+        std::cerr << "multi-pack-index обрезан" << std::endl;
+        return false;
+    }
+
+    numObjects = static_cast<uint32_t>(count);
+    mapped = std::move(file);
+    return true;
+}
+
+uint64_t MultiPackIndex::offsetAt(size_t i) const {
+    uint32_t offset = readBigEndian32(offsetTable + i * 8 + 4);
+    if (!(offset & LARGE_OFFSET_FLAG)) {
+        return offset;
+    }
+
+    uint32_t largeIndex = offset & ~LARGE_OFFSET_FLAG;
+    if (largeIndex >= largeOffsetCount) {
+        throw std::runtime_error("Некорректная ссылка на 64-битное смещение в multi-pack-index");
+    }
+    const unsigned char* entry = largeOffsetTable + static_cast<uint64_t>(largeIndex) * 8;
+    return (static_cast<uint64_t>(readBigEndian32(entry)) << 32) | readBigEndian32(entry + 4);
+}
+
+int64_t MultiPackIndex::findObject(const unsigned char* sha1) const {
+    uint32_t low = sha1[0] == 0 ? 0 : fanout[sha1[0] - 1];
+    uint32_t high = fanout[sha1[0]];
+
+    while (low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        int cmp = std::memcmp(sha1At(mid), sha1, 20);
+        if (cmp == 0) {
+            return mid;
+        }
+        if (cmp < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return -1;
+}
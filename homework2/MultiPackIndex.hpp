@@ -0,0 +1,58 @@
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#include <arpa/inet.h>
+#include "BigEndian.hpp"
+#include "MappedFile.hpp"
+
+#ifndef MULTIPACKINDEX_HPP
+#define MULTIPACKINDEX_HPP
+
+// Разбор objects/pack/multi-pack-index: один отсортированный список SHA-1
+// по всем покрытым pack файлам с номером pack файла и смещением объекта.
+// Файл отображается в память, таблицы читаются по месту.
+class MultiPackIndex {
+private:
+    static constexpr uint32_t MIDX_SIGNATURE = 0x4D494458;  // "MIDX"
+    static constexpr uint64_t MIDX_HEADER_SIZE = 12;
+    static constexpr uint32_t LARGE_OFFSET_FLAG = 0x80000000;
+
+    // Идентификаторы блоков (chunk) файла
+    static constexpr uint32_t CHUNK_PACK_NAMES = 0x504E414D;     // "PNAM"
+    static constexpr uint32_t CHUNK_OID_FANOUT = 0x4F494446;     // "OIDF"
+    static constexpr uint32_t CHUNK_OID_LOOKUP = 0x4F49444C;     // "OIDL"
+    static constexpr uint32_t CHUNK_OBJECT_OFFSETS = 0x4F4F4646; // "OOFF"
+    static constexpr uint32_t CHUNK_LARGE_OFFSETS = 0x4C4F4646;  // "LOFF"
+
+    std::unique_ptr<MappedFile> mapped;
+
+    std::vector<std::string> packNames;
+    uint32_t fanout[256] = {};
+    uint32_t numObjects = 0;
+    const unsigned char* oidTable = nullptr;
+    const unsigned char* offsetTable = nullptr;
+    const unsigned char* largeOffsetTable = nullptr;
+    uint64_t largeOffsetCount = 0;
+
+public:
+    bool mapFile(const std::string& filename);
+
+    bool isLoaded() const { return mapped != nullptr; }
+
+    // Имена .idx файлов покрытых pack файлов; номер в списке — номер pack файла
+    const std::vector<std::string>& packs() const { return packNames; }
+
+    size_t objectCount() const { return numObjects; }
+
+    const unsigned char* sha1At(size_t i) const { return oidTable + i * 20; }
+
+    uint32_t packAt(size_t i) const { return readBigEndian32(offsetTable + i * 8); }
+
+    uint64_t offsetAt(size_t i) const;
+
+    // Номер объекта или -1, если его нет
+    int64_t findObject(const unsigned char* sha1) const;
+};
+
+#endif
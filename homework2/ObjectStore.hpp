@@ -0,0 +1,20 @@
+#include <cstdint>
+#include <vector>
+#include "PackedObject.hpp"
+
+#ifndef OBJECTSTORE_HPP
+#define OBJECTSTORE_HPP
+
+// Общий интерфейс поиска объекта по SHA-1, независимо от того,
+// где он хранится: в pack файлах или отдельным файлом
+class ObjectStore {
+public:
+    virtual ~ObjectStore() = default;
+
+    virtual bool contains(const unsigned char* sha1) const = 0;
+
+    // false, если объекта нет; ошибки чтения — исключения
+    virtual bool readObject(const unsigned char* sha1, GitObjectType& type, std::vector<uint8_t>& content) const = 0;
+};
+
+#endif
@@ -0,0 +1,70 @@
+#include "PackReverseIndex.hpp"
+#include "BigEndian.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+
+bool PackReverseIndex::load(const std::string& revPath, const GitIdxParser& index, uint64_t packSize) {
+    std::ifstream input(revPath, std::ios::binary);
+    if (!input) {
+        return false;
+    }
+    std::vector<unsigned char> file((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+
+    size_t count = index.objectCount();
+    if (file.size() != RIDX_HEADER_SIZE + count * 4 + 40 || readBigEndian32(file.data()) != RIDX_SIGNATURE) {
+        std::cerr << "Неверный формат обратного индекса: " << revPath << std::endl;
+        return false;
+    }
+    if (readBigEndian32(file.data() + 4) != 1 || readBigEndian32(file.data() + 8) != 1) {
+        std::cerr << "Неподдерживаемая версия обратного индекса: " << revPath << std::endl;
+        return false;
+    }
+    // После таблицы записана контрольная сумма pack файла, как в концевике .idx
+    const unsigned char* packChecksum = file.data() + RIDX_HEADER_SIZE + count * 4;
+    if (!index.packChecksum() || std::memcmp(packChecksum, index.packChecksum(), 20) != 0) {
+        std::cerr << "Обратный индекс относится к другому pack файлу: " << revPath << std::endl;
+        return false;
+    }
+
+    positions.resize(count);
+    offsets.resize(count);
+    for (size_t r = 0; r < count; r++) {
+        positions[r] = readBigEndian32(file.data() + RIDX_HEADER_SIZE + r * 4);
+        offsets[r] = positions[r] < count ? index.offsetAt(positions[r]) : 0;
+        // Смещения обязаны строго возрастать, иначе таблица не перестановка индекса
+        if (positions[r] >= count || (r > 0 && offsets[r] <= offsets[r - 1])) {
+            std::cerr << "Обратный индекс не согласован с индексом: " << revPath << std::endl;
+            positions.clear();
+            offsets.clear();
+            return false;
+        }
+    }
+    packEnd = packSize - PACK_TRAILER_SIZE;
+    return true;
+}
+
+void PackReverseIndex::build(const GitIdxParser& index, uint64_t packSize) {
+    size_t count = index.objectCount();
+    positions.resize(count);
+    std::iota(positions.begin(), positions.end(), 0);
+    std::vector<uint64_t> indexOffsets(count);
+    for (size_t i = 0; i < count; i++) {
+        indexOffsets[i] = index.offsetAt(i);
+    }
+    std::sort(positions.begin(), positions.end(),
+              [&indexOffsets](uint32_t a, uint32_t b) { return indexOffsets[a] < indexOffsets[b]; });
+
+    offsets.resize(count);
+    for (size_t r = 0; r < count; r++) {
+        offsets[r] = indexOffsets[positions[r]];
+    }
+    packEnd = packSize - PACK_TRAILER_SIZE;
+}
+
+uint64_t PackReverseIndex::endOf(uint64_t pos) const {
+    auto it = std::upper_bound(offsets.begin(), offsets.end(), pos);
+    return it == offsets.end() ? packEnd : *it;
+}
@@ -0,0 +1,46 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "GitIdxParser.hpp"
+
+#ifndef PACKREVERSEINDEX_HPP
+#define PACKREVERSEINDEX_HPP
+
+// Обратный индекс pack файла: объекты в порядке смещений. Берётся из
+// pack-*.rev (формат RIDX, который пишет git), а если файла нет — строится
+// сортировкой смещений из .idx. Объект занимает место от своего смещения до
+// смещения следующего, так что известна точная длина его сжатых данных.
+class PackReverseIndex {
+private:
+    static constexpr uint32_t RIDX_SIGNATURE = 0x52494458;  // "RIDX"
+    static constexpr uint64_t RIDX_HEADER_SIZE = 12;
+    static constexpr uint64_t PACK_TRAILER_SIZE = 20;
+
+    // positions[r] — номер в .idx объекта, r-го по смещению; offsets[r] — его смещение
+    std::vector<uint32_t> positions;
+    std::vector<uint64_t> offsets;
+    // Начало концевика pack файла: здесь заканчивается последний объект
+    uint64_t packEnd = 0;
+
+public:
+    // false, если файл испорчен или относится к другому pack файлу
+    bool load(const std::string& revPath, const GitIdxParser& index, uint64_t packSize);
+
+    void build(const GitIdxParser& index, uint64_t packSize);
+
+    size_t objectCount() const { return offsets.size(); }
+
+    uint64_t offsetAt(size_t rank) const { return offsets[rank]; }
+
+    uint32_t indexPositionAt(size_t rank) const { return positions[rank]; }
+
+    // Место объекта в pack файле вместе с заголовком
+    uint64_t diskSizeAt(size_t rank) const {
+        return (rank + 1 < offsets.size() ? offsets[rank + 1] : packEnd) - offsets[rank];
+    }
+
+    // Конец объекта, которому принадлежит позиция pos: смещение следующего объекта
+    uint64_t endOf(uint64_t pos) const;
+};
+
+#endif
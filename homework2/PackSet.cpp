@@ -0,0 +1,287 @@
+#include "PackSet.hpp"
+#include "CommitCache.hpp"
+#include "Sha1.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+
+PackSet::PackSet(const std::string& packDir) {
+    if (!std::filesystem::is_directory(packDir)) {
+        throw std::runtime_error("Каталог pack файлов не найден: " + packDir);
+    }
+
+    // Пары .idx/.pack; pack без индекса (например, недописанный) пропускаем
+    std::vector<std::string> names;
+    for (const auto& entry : std::filesystem::directory_iterator(packDir)) {
+        const std::filesystem::path& path = entry.path();
+        if (path.extension() == ".idx") {
+            std::filesystem::path packPath = path;
+            packPath.replace_extension(".pack");
+            if (std::filesystem::exists(packPath)) {
+                names.push_back(path.stem().string());
+            }
+        }
+    }
+    std::sort(names.begin(), names.end());
+
+    for (const std::string& name : names) {
+        std::unique_ptr<Pack> pack = std::make_unique<Pack>();
+        std::filesystem::path base = std::filesystem::path(packDir) / name;
+        pack->name = name;
+        pack->idxPath = base.string() + ".idx";
+        pack->packPath = base.string() + ".pack";
+        packList.push_back(std::move(pack));
+    }
+
+    // Испорченный multi-pack-index не мешает: тогда ищем по всем индексам
+    std::filesystem::path midxPath = std::filesystem::path(packDir) / "multi-pack-index";
+    if (std::filesystem::exists(midxPath) && midx.mapFile(midxPath.string())) {
+        for (const std::string& idxName : midx.packs()) {
+            std::string name = std::filesystem::path(idxName).stem().string();
+            auto it = std::lower_bound(names.begin(), names.end(), name);
+            if (it != names.end() && *it == name) {
+                size_t i = it - names.begin();
+                packList[i]->coveredByMidx = true;
+                midxPack.push_back(static_cast<int64_t>(i));
+            } else {
+                midxPack.push_back(-1);
+            }
+        }
+    }
+}
+
+const GitIdxParser* PackSet::indexOf(Pack& pack) const {
+    std::call_once(pack.indexOnce, [&]() {
+        std::unique_ptr<GitIdxParser> index = std::make_unique<GitIdxParser>();
+        if (index->mapFile(pack.idxPath)) {
+            pack.index = std::move(index);
+        }
+    });
+    return pack.index.get();
+}
+
+const GitPackParser* PackSet::parserOf(Pack& pack) const {
+    const GitIdxParser* index = indexOf(pack);
+    if (!index) {
+        return nullptr;
+    }
+    std::call_once(pack.packOnce, [&]() {
+        std::unique_ptr<GitPackParser> parser = std::make_unique<GitPackParser>(pack.packPath);
+        parser->setIndex(index);
+        parser->loadReverseIndex();
+        parser->deltaBaseCache().setMemoryLimit(packCacheLimit());
+        parser->setDecompressor(decompressorBackend);
+        pack.parser = std::move(parser);
+        openedPacks++;
+    });
+    return pack.parser.get();
+}
+
+void PackSet::setDeltaCacheLimit(size_t bytes) {
+    deltaCacheLimit = bytes;
+    for (const std::unique_ptr<Pack>& pack : packList) {
+        if (pack->parser) {
+            pack->parser->deltaBaseCache().setMemoryLimit(packCacheLimit());
+        }
+    }
+}
+
+void PackSet::setDecompressor(Decompressor::Backend backend) {
+    if (!Decompressor::isAvailable(backend)) {
+        throw std::runtime_error("Распаковщик " + Decompressor::backendName(backend) + " не подключён при сборке");
+    }
+    decompressorBackend = backend;
+    for (const std::unique_ptr<Pack>& pack : packList) {
+        if (pack->parser) {
+            pack->parser->setDecompressor(backend);
+        }
+    }
+}
+
+GitPackParser::InflateBenchmark PackSet::benchmarkInflate(Decompressor::Backend backend) const {
+    GitPackParser::InflateBenchmark total;
+    for (const std::unique_ptr<Pack>& pack : packList) {
+        const GitPackParser* parser = parserOf(*pack);
+        if (!parser) {
+            continue;
+        }
+        GitPackParser::InflateBenchmark result = parser->benchmarkInflate(backend);
+        total.objects += result.objects;
+        total.compressedBytes += result.compressedBytes;
+        total.inflatedBytes += result.inflatedBytes;
+        total.seconds += result.seconds;
+    }
+    return total;
+}
+
+GitPackParser::DeltaBenchmark PackSet::benchmarkDelta() const {
+    GitPackParser::DeltaBenchmark total;
+    for (const std::unique_ptr<Pack>& pack : packList) {
+        const GitPackParser* parser = parserOf(*pack);
+        if (!parser) {
+            continue;
+        }
+        GitPackParser::DeltaBenchmark result = parser->benchmarkDelta();
+        total.deltas += result.deltas;
+        total.deltaBytes += result.deltaBytes;
+        total.resultBytes += result.resultBytes;
+        total.corrupt += result.corrupt;
+        total.seconds += result.seconds;
+    }
+    return total;
+}
+
+std::string PackSet::fingerprint() const {
+    Sha1 sha1;
+    for (const std::unique_ptr<Pack>& pack : packList) {
+        sha1.update(pack->name.data(), pack->name.size());
+        sha1.update("\n", 1);
+    }
+    unsigned char digest[20];
+    sha1.final(digest);
+    return GitIdxParser::bytesToHex(digest, 20);
+}
+
+GitPackParser::SizeStats PackSet::sizeStatistics() const {
+    GitPackParser::SizeStats total;
+    for (const std::unique_ptr<Pack>& pack : packList) {
+        const GitPackParser* parser = parserOf(*pack);
+        if (!parser) {
+            continue;
+        }
+        GitPackParser::SizeStats stats = parser->sizeStatistics();
+        for (int type = 0; type < 8; type++) {
+            total.objects[type] += stats.objects[type];
+            total.bytes[type] += stats.bytes[type];
+        }
+        if (stats.largest > total.largest) {
+            total.largest = stats.largest;
+            total.largestOffset = stats.largestOffset;
+        }
+    }
+    return total;
+}
+
+bool PackSet::findObject(const unsigned char* sha1, size_t& pack, uint64_t& offset) const {
+    if (midx.isLoaded()) {
+        int64_t i = midx.findObject(sha1);
+        if (i >= 0) {
+            uint32_t packId = midx.packAt(i);
+            if (packId < midxPack.size() && midxPack[packId] >= 0) {
+                pack = static_cast<size_t>(midxPack[packId]);
+                offset = midx.offsetAt(i);
+                return true;
+            }
+        }
+    }
+
+    for (size_t p = 0; p < packList.size(); p++) {
+        if (packList[p]->coveredByMidx) {
+            continue;
+        }
+        const GitIdxParser* index = indexOf(*packList[p]);
+        if (index && index->findOffset(sha1, offset)) {
+            pack = p;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool PackSet::contains(const unsigned char* sha1) const {
+    size_t pack;
+    uint64_t offset;
+    return findObject(sha1, pack, offset);
+}
+
+bool PackSet::readObject(const unsigned char* sha1, GitObjectType& type, std::vector<uint8_t>& content) const {
+    size_t pack;
+    uint64_t offset;
+    if (!findObject(sha1, pack, offset)) {
+        return false;
+    }
+    const GitPackParser* parser = parserOf(*packList[pack]);
+    if (!parser) {
+        return false;
+    }
+    type = parser->getObjectContent(offset, content);
+    return true;
+}
+
+std::vector<CommitRecord> PackSet::collectCommits(const int& from, const ExtractOptions& options,
+                                                  DeltaBaseCache::Stats* stats) {
+    setDeltaCacheLimit(options.deltaCacheLimit);
+
+    // С кэшем разбираются все коммиты pack файла, а по дате отбираются уже записанные
+    CommitCache* cache = options.resultCache;
+    const int decodeFrom = cache ? std::numeric_limits<int>::min() : from;
+
+    // Базы, накопленные при чтении отдельных объектов, уступают место разбору
+    for (const std::unique_ptr<Pack>& pack : packList) {
+        if (pack->parser) {
+            pack->parser->deltaBaseCache().clear();
+        }
+    }
+
+    std::vector<CommitRecord> commits;
+    std::vector<std::string> livePacks;
+    DeltaBaseCache::Stats total;
+    for (const std::unique_ptr<Pack>& pack : packList) {
+        const GitIdxParser* index = indexOf(*pack);
+        if (!index) {
+            continue;
+        }
+        std::vector<CommitRecord> part;
+        if (cache) {
+            livePacks.push_back(GitIdxParser::bytesToHex(index->packChecksum(), 20));
+            if (cache->loadPack(index->packChecksum(), part)) {
+                cache->packStats.hits++;
+                CommitCache::dropOlder(part, from);
+                commits.insert(commits.end(), std::make_move_iterator(part.begin()), std::make_move_iterator(part.end()));
+                continue;
+            }
+            cache->packStats.misses++;
+        }
+
+        const GitPackParser* parser = parserOf(*pack);
+        if (!parser) {
+            continue;
+        }
+
+        DeltaBaseCache::Stats packStats;
+        pack->parser->deltaBaseCache().setMemoryLimit(deltaCacheLimit);
+        size_t failures = 0;
+        part = pack->index->collectCommits(*parser, decodeFrom, options, &packStats, &failures);
+        if (cache) {
+            // Частично разобранный pack файл не кэшируется: иначе пропущенные
+            // коммиты не появились бы и в следующих запусках
+            if (!failures) {
+                cache->storePack(index->packChecksum(), part);
+            }
+            CommitCache::dropOlder(part, from);
+        }
+        commits.insert(commits.end(), std::make_move_iterator(part.begin()), std::make_move_iterator(part.end()));
+        total.hits += packStats.hits;
+        total.misses += packStats.misses;
+        total.evictions += packStats.evictions;
+
+        // Базы этого pack файла больше не нужны, память отдаём следующему
+        pack->parser->deltaBaseCache().clear();
+        pack->parser->deltaBaseCache().setMemoryLimit(packCacheLimit());
+    }
+
+    // Записи pack файлов, которые git gc заменил или удалил, больше не нужны
+    if (cache) {
+        cache->prunePacks(livePacks);
+    }
+
+    // Один объект может лежать в нескольких pack файлах
+    GitIdxParser::sortUniqueCommits(commits);
+
+    if (stats) {
+        *stats = total;
+    }
+    return commits;
+}
@@ -0,0 +1,100 @@
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "GitIdxParser.hpp"
+#include "GitPackParser.hpp"
+#include "MultiPackIndex.hpp"
+#include "ObjectStore.hpp"
+
+#ifndef PACKSET_HPP
+#define PACKSET_HPP
+
+// Все pack файлы каталога objects/pack. Если есть multi-pack-index, поиск
+// идёт сначала по нему, затем по pack файлам, которые он не покрывает.
+// Индексы и pack файлы открываются лениво, при первом обращении.
+// Поиск и чтение объектов потокобезопасны.
+class PackSet : public ObjectStore {
+private:
+    struct Pack {
+        std::string name;  // имя без расширения, например pack-<sha1>
+        std::string idxPath;
+        std::string packPath;
+        bool coveredByMidx = false;
+
+        std::once_flag indexOnce;
+        std::once_flag packOnce;
+        std::unique_ptr<GitIdxParser> index;
+        std::unique_ptr<GitPackParser> parser;
+    };
+
+    std::vector<std::unique_ptr<Pack>> packList;
+    MultiPackIndex midx;
+    // midxPack[i] — номер в packList для i-го pack файла multi-pack-index или -1
+    std::vector<int64_t> midxPack;
+
+    size_t deltaCacheLimit = DeltaBaseCache::DEFAULT_MEMORY_LIMIT;
+    Decompressor::Backend decompressorBackend = Decompressor::Backend::ZLIB;
+    mutable std::atomic<size_t> openedPacks{0};
+
+    // Индекс pack файла; nullptr, если его не удалось прочитать
+    const GitIdxParser* indexOf(Pack& pack) const;
+
+    const GitPackParser* parserOf(Pack& pack) const;
+
+    // Доля бюджета кэша баз дельт на один pack файл: открытые при чтении
+    // объектов pack файлы вместе не превышают deltaCacheLimit
+    size_t packCacheLimit() const { return deltaCacheLimit / std::max<size_t>(packList.size(), 1); }
+
+public:
+    explicit PackSet(const std::string& packDir);
+
+    size_t packCount() const { return packList.size(); }
+
+    bool hasMultiPackIndex() const { return midx.isLoaded(); }
+
+    // Сколько pack файлов уже открыто для чтения объектов
+    size_t openedPackCount() const { return openedPacks.load(); }
+
+    // Общий бюджет кэшей баз дельт всех pack файлов набора
+    void setDeltaCacheLimit(size_t bytes);
+
+    // Распаковщик для всех pack файлов набора; runtime_error, если его нет в сборке
+    void setDecompressor(Decompressor::Backend backend);
+
+    // Индекс и парсер i-го pack файла в порядке имён; открываются при первом вызове.
+    // nullptr, если файлы не удалось прочитать
+    const GitIdxParser* packIndex(size_t i) const { return indexOf(*packList[i]); }
+
+    const GitPackParser* packParser(size_t i) const { return parserOf(*packList[i]); }
+
+    // SHA-1 от имён всех pack файлов: имя содержит контрольную сумму pack файла,
+    // поэтому после git gc или git repack отпечаток меняется
+    std::string fingerprint() const;
+
+    // Размеры объектов на диске по всем pack файлам; открывает каждый pack файл
+    GitPackParser::SizeStats sizeStatistics() const;
+
+    // Замер распаковки всех pack файлов набора распаковщиком backend
+    GitPackParser::InflateBenchmark benchmarkInflate(Decompressor::Backend backend) const;
+
+    // Замер наложения дельт всех pack файлов набора
+    GitPackParser::DeltaBenchmark benchmarkDelta() const;
+
+    // Номер pack файла и смещение объекта в нём
+    bool findObject(const unsigned char* sha1, size_t& pack, uint64_t& offset) const;
+
+    bool contains(const unsigned char* sha1) const override;
+
+    bool readObject(const unsigned char* sha1, GitObjectType& type, std::vector<uint8_t>& content) const override;
+
+    // Коммиты не старше from из всех pack файлов, по SHA-1 без повторов.
+    // С options.resultCache разбираются только pack файлы, которых нет в кэше.
+    // Pack файлы разбираются по одному, и разбираемый получает весь бюджет кэша
+    std::vector<CommitRecord> collectCommits(const int& from, const ExtractOptions& options = {},
+                                             DeltaBaseCache::Stats* stats = nullptr);
+};
+
+#endif
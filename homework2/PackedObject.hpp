@@ -3,7 +3,7 @@
 #include <string>
 
 #ifndef PACKEDOBJECT_HPP
-#define PACKETOBJECT_HPP
+#define PACKEDOBJECT_HPP
 
 enum class GitObjectType {
     COMMIT = 1,
@@ -20,7 +20,8 @@ public:
     size_t size;
     std::vector<uint8_t> data;
     uint64_t baseOffset;  // Для OFS_DELTA
-    std::string baseHash; // Для REF_DELTA
+    unsigned char baseHash[20]; // Для REF_DELTA
+    uint64_t dataOffset;  // Начало сжатых данных в pack файле
 };
 
 #endif
@@ -0,0 +1,81 @@
+#include "ParallelFor.hpp"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Участок диапазона: порции выдаются атомарным счётчиком и хозяину, и ворам
+struct Shard {
+    std::atomic<size_t> next{0};
+    size_t end = 0;
+};
+
+}
+
+unsigned resolveThreadCount(unsigned threads) {
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+    }
+    return std::max(threads, 1u);
+}
+
+void parallelFor(size_t count, unsigned threads, size_t grain,
+                 const std::function<void(unsigned worker, size_t begin, size_t end)>& body) {
+    grain = std::max<size_t>(grain, 1);
+    size_t chunks = (count + grain - 1) / grain;
+    threads = static_cast<unsigned>(std::min<size_t>(resolveThreadCount(threads), std::max<size_t>(chunks, 1)));
+
+    if (threads == 1) {
+        if (count > 0) {
+            body(0, 0, count);
+        }
+        return;
+    }
+
+    std::unique_ptr<Shard[]> shards(new Shard[threads]);
+    for (unsigned i = 0; i < threads; i++) {
+        shards[i].next = chunks * i / threads;
+        shards[i].end = chunks * (i + 1) / threads;
+    }
+
+    std::exception_ptr failure;
+    std::mutex failureMutex;
+
+    auto worker = [&](unsigned self) {
+        try {
+            // Свой участок, затем остальные по кругу
+            for (unsigned k = 0; k < threads; k++) {
+                Shard& shard = shards[(self + k) % threads];
+                size_t chunk;
+                while ((chunk = shard.next.fetch_add(1)) < shard.end) {
+                    size_t begin = chunk * grain;
+                    body(self, begin, std::min(begin + grain, count));
+                }
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(failureMutex);
+            if (!failure) {
+                failure = std::current_exception();
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    for (unsigned i = 1; i < threads; i++) {
+        pool.emplace_back(worker, i);
+    }
+    worker(0);
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
@@ -0,0 +1,18 @@
+#include <cstddef>
+#include <functional>
+
+#ifndef PARALLELFOR_HPP
+#define PARALLELFOR_HPP
+
+// Обработка диапазона [0, count) на threads потоках. Диапазон делится на
+// участки по числу потоков, участок — на порции по grain элементов. Поток
+// сначала разбирает порции своего участка, затем забирает порции чужих.
+// body(worker, begin, end) вызывается для каждой порции; worker — номер потока.
+// threads == 0 означает число аппаратных потоков. Первое исключение из body
+// пробрасывается после завершения всех потоков.
+void parallelFor(size_t count, unsigned threads, size_t grain,
+                 const std::function<void(unsigned worker, size_t begin, size_t end)>& body);
+
+unsigned resolveThreadCount(unsigned threads);
+
+#endif
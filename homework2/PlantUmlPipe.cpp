@@ -0,0 +1,243 @@
+#include "PlantUmlPipe.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <poll.h>
+#include <pthread.h>
+#include <stdexcept>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace {
+
+// write, после которого запись в канал завершившегося процесса даёт EPIPE,
+// а не SIGPIPE: сигнал блокируется на время вызова только в этом потоке
+ssize_t writeWithoutSigpipe(int fd, const void* data, size_t size) {
+    sigset_t pipeSignal, previous, pending;
+    sigemptyset(&pipeSignal);
+    sigaddset(&pipeSignal, SIGPIPE);
+    sigpending(&pending);
+    bool alreadyPending = sigismember(&pending, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &pipeSignal, &previous);
+
+    ssize_t written = write(fd, data, size);
+    int error = errno;
+    if (written < 0 && error == EPIPE && !alreadyPending) {
+        // Забираем сигнал, чтобы он не сработал после восстановления маски
+        timespec zero = {0, 0};
+        sigtimedwait(&pipeSignal, nullptr, &zero);
+    }
+
+    pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+    errno = error;
+    return written;
+}
+
+}
+
+PlantUmlPipe::PlantUmlPipe(const std::vector<std::string>& command, size_t maxInFlight, const std::string& delimiter)
+    : delimiter(delimiter), maxInFlight(std::max<size_t>(1, maxInFlight)) {
+    if (command.empty()) {
+        throw std::runtime_error("Не задана команда PlantUML");
+    }
+
+    int toChild[2], fromChild[2];
+    if (pipe(toChild) != 0) {
+        throw std::runtime_error("Не удалось создать канал: " + std::string(std::strerror(errno)));
+    }
+    if (pipe(fromChild) != 0) {
+        close(toChild[0]);
+        close(toChild[1]);
+        throw std::runtime_error("Не удалось создать канал: " + std::string(std::strerror(errno)));
+    }
+
+    std::vector<std::string> args = command;
+    args.push_back("-pipedelimitor");
+    args.push_back(delimiter);
+    std::vector<char*> argv;
+    for (std::string& arg : args) {
+        argv.push_back(&arg[0]);
+    }
+    argv.push_back(nullptr);
+
+    child = fork();
+    if (child < 0) {
+        close(toChild[0]);
+        close(toChild[1]);
+        close(fromChild[0]);
+        close(fromChild[1]);
+        throw std::runtime_error("Не удалось запустить PlantUML: " + std::string(std::strerror(errno)));
+    }
+    if (child == 0) {
+        dup2(toChild[0], STDIN_FILENO);
+        dup2(fromChild[1], STDOUT_FILENO);
+        close(toChild[0]);
+        close(toChild[1]);
+        close(fromChild[0]);
+        close(fromChild[1]);
+        execvp(argv[0], argv.data());
+        _exit(127);
+    }
+
+    close(toChild[0]);
+    close(fromChild[1]);
+    input = toChild[1];
+    output = fromChild[0];
+    fcntl(input, F_SETFL, fcntl(input, F_GETFL) | O_NONBLOCK);
+    fcntl(output, F_SETFL, fcntl(output, F_GETFL) | O_NONBLOCK);
+    fcntl(input, F_SETFD, FD_CLOEXEC);
+    fcntl(output, F_SETFD, FD_CLOEXEC);
+}
+
+PlantUmlPipe::~PlantUmlPipe() {
+    // Конец stdin — сигнал PlantUML завершиться
+    closeInput();
+    if (output >= 0) {
+        close(output);
+    }
+    if (child > 0 && (failed || !waitForExit(EXIT_TIMEOUT_MS))) {
+        kill(child, SIGTERM);
+        if (!waitForExit(TERMINATE_TIMEOUT_MS)) {
+            kill(child, SIGKILL);
+            waitForExit(-1);
+        }
+    }
+}
+
+bool PlantUmlPipe::waitForExit(int timeoutMs) {
+    // timeoutMs < 0 — ждать без ограничения, как после SIGKILL
+    for (int waited = 0;; waited += 10) {
+        int status;
+        pid_t result = waitpid(child, &status, timeoutMs < 0 ? 0 : WNOHANG);
+        if (result == child || (result < 0 && errno != EINTR)) {
+            child = -1;
+            return true;
+        }
+        if (timeoutMs >= 0 && waited >= timeoutMs) {
+            return false;
+        }
+        if (result == 0) {
+            usleep(10000);
+        }
+    }
+}
+
+void PlantUmlPipe::closeInput() {
+    if (input >= 0) {
+        close(input);
+        input = -1;
+    }
+}
+
+std::vector<std::string> PlantUmlPipe::plantUmlCommand(const std::string& jarPath, const std::string& format) {
+    return {"java", "-jar", jarPath, "-pipe", "-t" + format};
+}
+
+void PlantUmlPipe::render(const std::vector<std::string>& documents, const OutputHandler& onOutput) {
+    if (input < 0) {
+        throw std::runtime_error("PlantUML уже остановлен");
+    }
+    // Сбрасывается только в конце удачного рендера
+    failed = true;
+
+    const std::string marker = delimiter + "\n";
+    size_t nextDocument = 0;  // первый ещё не отправленный до конца документ
+    size_t sentBytes = 0;     // отправлено байт из него
+    size_t done = 0;          // документов с прочитанным ответом
+    std::vector<uint8_t> received;
+    size_t searchFrom = 0;
+    std::vector<uint8_t> chunk(READ_CHUNK_SIZE);
+
+    // Документ должен заканчиваться переводом строки, иначе PlantUML не увидит @enduml
+    auto needsNewline = [&](size_t i) { return documents[i].empty() || documents[i].back() != '\n'; };
+
+    while (done < documents.size()) {
+        bool canSend = nextDocument < documents.size() && nextDocument - done < maxInFlight;
+        pollfd fds[2] = {{output, POLLIN, 0}, {input, POLLOUT, 0}};
+        int ready = poll(fds, canSend ? 2 : 1, RESPONSE_TIMEOUT_MS);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("Ошибка ожидания PlantUML: " + std::string(std::strerror(errno)));
+        }
+        if (ready == 0) {
+            throw std::runtime_error("PlantUML не отвечает");
+        }
+
+        if (canSend && (fds[1].revents & (POLLOUT | POLLERR | POLLHUP))) {
+            const std::string& text = documents[nextDocument];
+            ssize_t written;
+            if (sentBytes < text.size()) {
+                written = writeWithoutSigpipe(input, text.data() + sentBytes, text.size() - sentBytes);
+            } else {
+                written = writeWithoutSigpipe(input, "\n", 1);
+            }
+            if (written < 0 && errno != EAGAIN && errno != EINTR) {
+                throw std::runtime_error("Ошибка записи в PlantUML: " + std::string(std::strerror(errno)));
+            }
+            if (written > 0) {
+                sentBytes += static_cast<size_t>(written);
+                size_t total = text.size() + (needsNewline(nextDocument) ? 1 : 0);
+                if (sentBytes >= total) {
+                    nextDocument++;
+                    sentBytes = 0;
+                }
+            }
+        }
+
+        if (fds[0].revents & (POLLIN | POLLERR | POLLHUP)) {
+            ssize_t count = read(output, chunk.data(), chunk.size());
+            if (count < 0 && errno != EAGAIN && errno != EINTR) {
+                throw std::runtime_error("Ошибка чтения из PlantUML: " + std::string(std::strerror(errno)));
+            }
+            if (count == 0) {
+                throw std::runtime_error("PlantUML завершился раньше, чем вернул все рисунки");
+            }
+            if (count > 0) {
+                received.insert(received.end(), chunk.begin(), chunk.begin() + count);
+            }
+
+            // Ответы отделяются строкой-разделителем
+            while (true) {
+                auto it = std::search(received.begin() + searchFrom, received.end(), marker.begin(), marker.end());
+                if (it == received.end()) {
+                    searchFrom = received.size() > marker.size() ? received.size() - marker.size() : 0;
+                    break;
+                }
+                std::vector<uint8_t> image(received.begin(), it);
+                received.erase(received.begin(), it + marker.size());
+                searchFrom = 0;
+                onOutput(done++, image);
+            }
+        }
+    }
+    failed = false;
+}
+
+std::vector<std::string> PlantUmlPipe::renderFiles(const std::vector<std::string>& pumlFiles,
+                                                   const std::string& format) {
+    std::vector<std::string> documents, outputs;
+    for (const std::string& path : pumlFiles) {
+        std::ifstream file(path);
+        if (!file) {
+            throw std::runtime_error("Файл " + path + " не найден.");
+        }
+        documents.emplace_back(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        outputs.push_back(std::filesystem::path(path).replace_extension("." + format).string());
+    }
+
+    render(documents, [&](size_t i, const std::vector<uint8_t>& image) {
+        std::ofstream file(outputs[i], std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(image.data()), image.size());
+        if (!file) {
+            throw std::runtime_error("Не удалось записать " + outputs[i]);
+        }
+    });
+    return outputs;
+}
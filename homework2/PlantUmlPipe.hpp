@@ -0,0 +1,65 @@
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+#ifndef PLANTUMLPIPE_HPP
+#define PLANTUMLPIPE_HPP
+
+// PlantUML, запущенный один раз в режиме -pipe: документы .puml пишутся ему
+// в stdin, картинки читаются из stdout, после каждой идёт строка-разделитель.
+// JVM стартует один раз на все документы. В работе одновременно не больше
+// maxInFlight документов: пока ответы не прочитаны, новые не отправляются,
+// а чтение и запись идут через poll, поэтому заполненный канал не блокирует
+// ни нас, ни PlantUML. Вместо java можно запустить любую программу с тем же
+// протоколом, например заглушку в тестах.
+class PlantUmlPipe {
+private:
+    // Сколько ждать ответа, прежде чем считать процесс зависшим
+    static constexpr int RESPONSE_TIMEOUT_MS = 120000;
+    // Сколько ждать завершения после закрытия stdin и после SIGTERM
+    static constexpr int EXIT_TIMEOUT_MS = 5000;
+    static constexpr int TERMINATE_TIMEOUT_MS = 1000;
+    static constexpr size_t READ_CHUNK_SIZE = 64 * 1024;
+
+    pid_t child = -1;
+    int input = -1;   // stdin процесса
+    int output = -1;  // stdout процесса
+    std::string delimiter;
+    size_t maxInFlight;
+    // render завершился исключением: процесс мог зависнуть, ждать его не стоит
+    bool failed = false;
+
+    void closeInput();
+
+    // true, если процесс завершился за timeoutMs
+    bool waitForExit(int timeoutMs);
+
+public:
+    static constexpr const char* DEFAULT_DELIMITER = "___GRAPHVIZ_PLANTUML_END___";
+
+    using OutputHandler = std::function<void(size_t document, const std::vector<uint8_t>& image)>;
+
+    // command — программа и аргументы; разделитель передаётся ей через -pipedelimitor
+    PlantUmlPipe(const std::vector<std::string>& command, size_t maxInFlight = 4,
+                 const std::string& delimiter = DEFAULT_DELIMITER);
+
+    // Закрывает stdin и ждёт завершения не дольше EXIT_TIMEOUT_MS; зависший
+    // процесс или процесс после ошибки render получает SIGTERM, затем SIGKILL
+    ~PlantUmlPipe();
+
+    PlantUmlPipe(const PlantUmlPipe&) = delete;
+    PlantUmlPipe& operator=(const PlantUmlPipe&) = delete;
+
+    // java -jar plantuml.jar -pipe -t<format>
+    static std::vector<std::string> plantUmlCommand(const std::string& jarPath, const std::string& format = "png");
+
+    // Документы уходят по порядку; onOutput вызывается в том же порядке
+    void render(const std::vector<std::string>& documents, const OutputHandler& onOutput);
+
+    // Рисунок для каждого файла .puml рядом с ним, с расширением format; пути к рисункам
+    std::vector<std::string> renderFiles(const std::vector<std::string>& pumlFiles, const std::string& format = "png");
+};
+
+#endif
@@ -0,0 +1,107 @@
+#include "PngWriter.hpp"
+#include "BigEndian.hpp"
+#include <cstring>
+#include <stdexcept>
+
+PngWriter::PngWriter(const std::string& path, uint32_t width, uint32_t height)
+    : file(path, std::ios::binary | std::ios::trunc), width(width), height(height) {
+    if (!file) {
+        throw std::runtime_error("Не удалось создать файл " + path);
+    }
+    if (width == 0 || height == 0) {
+        throw std::runtime_error("Пустое изображение");
+    }
+
+    std::memset(&zs, 0, sizeof(zs));
+    // Быстрое сжатие: на больших графах иначе оно занимает почти всё время отрисовки
+    if (deflateInit(&zs, Z_BEST_SPEED) != Z_OK) {
+        throw std::runtime_error("Не удалось инициализировать zlib");
+    }
+
+    static const unsigned char signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    file.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+
+    // IHDR: размеры, 8 бит на канал, RGB, без чересстрочности
+    std::vector<unsigned char> header;
+    appendBigEndian32(header, width);
+    appendBigEndian32(header, height);
+    header.insert(header.end(), {8, 2, 0, 0, 0});
+    writeChunk("IHDR", header.data(), header.size());
+
+    rowBuffer.resize(1 + static_cast<size_t>(width) * 3);
+}
+
+PngWriter::~PngWriter() {
+    deflateEnd(&zs);
+}
+
+void PngWriter::writeChunk(const char* type, const unsigned char* data, size_t size) {
+    std::vector<unsigned char> prefix;
+    appendBigEndian32(prefix, static_cast<uint32_t>(size));
+    file.write(reinterpret_cast<const char*>(prefix.data()), 4);
+    file.write(type, 4);
+    file.write(reinterpret_cast<const char*>(data), size);
+
+    // CRC считается по типу и данным блока
+    uLong crc = crc32(0, reinterpret_cast<const Bytef*>(type), 4);
+    if (size > 0) {
+        crc = crc32(crc, data, static_cast<uInt>(size));
+    }
+    std::vector<unsigned char> suffix;
+    appendBigEndian32(suffix, static_cast<uint32_t>(crc));
+    file.write(reinterpret_cast<const char*>(suffix.data()), 4);
+}
+
+void PngWriter::deflateBytes(const unsigned char* input, size_t size, int flush) {
+    zs.next_in = const_cast<Bytef*>(input);
+    zs.avail_in = static_cast<uInt>(size);
+    unsigned char out[16384];
+    int ret;
+    do {
+        zs.next_out = out;
+        zs.avail_out = sizeof(out);
+        ret = deflate(&zs, flush);
+        if (ret == Z_STREAM_ERROR) {
+            throw std::runtime_error("Ошибка сжатия PNG");
+        }
+        compressed.insert(compressed.end(), out, out + (sizeof(out) - zs.avail_out));
+        if (compressed.size() >= IDAT_CHUNK_SIZE) {
+            writeChunk("IDAT", compressed.data(), compressed.size());
+            compressed.clear();
+        }
+    } while (zs.avail_out == 0 || (flush == Z_FINISH && ret != Z_STREAM_END));
+}
+
+void PngWriter::writeRows(const unsigned char* rgb, uint32_t rows) {
+    if (rowsWritten + rows > height) {
+        throw std::runtime_error("Строк больше, чем высота изображения");
+    }
+    size_t stride = static_cast<size_t>(width) * 3;
+    for (uint32_t r = 0; r < rows; r++) {
+        // Фильтр 0: строка как есть
+        rowBuffer[0] = 0;
+        std::memcpy(rowBuffer.data() + 1, rgb + r * stride, stride);
+        deflateBytes(rowBuffer.data(), rowBuffer.size(), Z_NO_FLUSH);
+    }
+    rowsWritten += rows;
+}
+
+void PngWriter::finish() {
+    if (finished) {
+        return;
+    }
+    if (rowsWritten != height) {
+        throw std::runtime_error("Записаны не все строки изображения");
+    }
+    deflateBytes(nullptr, 0, Z_FINISH);
+    if (!compressed.empty()) {
+        writeChunk("IDAT", compressed.data(), compressed.size());
+        compressed.clear();
+    }
+    writeChunk("IEND", nullptr, 0);
+    file.close();
+    finished = true;
+    if (!file) {
+        throw std::runtime_error("Ошибка записи PNG файла");
+    }
+}
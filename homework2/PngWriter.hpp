@@ -0,0 +1,47 @@
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+#ifndef PNGWRITER_HPP
+#define PNGWRITER_HPP
+
+// Потоковая запись RGB изображения в PNG: строки приходят сверху вниз
+// порциями, сжимаются zlib и сразу уходят в файл блоками IDAT, поэтому
+// всё изображение в памяти не держится
+class PngWriter {
+private:
+    // Размер сжатых данных, после которого пишется очередной блок IDAT
+    static constexpr size_t IDAT_CHUNK_SIZE = 64 * 1024;
+
+    std::ofstream file;
+    uint32_t width;
+    uint32_t height;
+    uint32_t rowsWritten = 0;
+    z_stream zs;
+    std::vector<unsigned char> compressed;
+    std::vector<unsigned char> rowBuffer;
+    bool finished = false;
+
+    void writeChunk(const char* type, const unsigned char* data, size_t size);
+
+    // Сжатие input; при flush — до конца потока
+    void deflateBytes(const unsigned char* input, size_t size, int flush);
+
+public:
+    PngWriter(const std::string& path, uint32_t width, uint32_t height);
+
+    ~PngWriter();
+
+    PngWriter(const PngWriter&) = delete;
+    PngWriter& operator=(const PngWriter&) = delete;
+
+    // rows строк по width * 3 байт RGB подряд
+    void writeRows(const unsigned char* rgb, uint32_t rows);
+
+    // Завершение файла; вызывается после записи всех height строк
+    void finish();
+};
+
+#endif
@@ -0,0 +1,106 @@
+#include "Sha1.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+inline uint32_t rotl(uint32_t value, int bits) {
+    return (value << bits) | (value >> (32 - bits));
+}
+
+}
+
+Sha1::Sha1() : state{0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0} {}
+
+void Sha1::processBlock(const unsigned char* data) {
+    uint32_t w[80];
+    for (int i = 0; i < 16; i++) {
+        w[i] = (uint32_t(data[i * 4]) << 24) | (uint32_t(data[i * 4 + 1]) << 16) |
+               (uint32_t(data[i * 4 + 2]) << 8) | uint32_t(data[i * 4 + 3]);
+    }
+    for (int i = 16; i < 80; i++) {
+        w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    }
+
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+    for (int i = 0; i < 80; i++) {
+        uint32_t f, k;
+        if (i < 20) {
+            f = (b & c) | (~b & d);
+            k = 0x5A827999;
+        } else if (i < 40) {
+            f = b ^ c ^ d;
+            k = 0x6ED9EBA1;
+        } else if (i < 60) {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8F1BBCDC;
+        } else {
+            f = b ^ c ^ d;
+            k = 0xCA62C1D6;
+        }
+        uint32_t temp = rotl(a, 5) + f + e + k + w[i];
+        e = d;
+        d = c;
+        c = rotl(b, 30);
+        b = a;
+        a = temp;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+}
+
+void Sha1::update(const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    totalBytes += size;
+
+    if (blockUsed > 0) {
+        size_t take = std::min(size, sizeof(block) - blockUsed);
+        std::memcpy(block + blockUsed, bytes, take);
+        blockUsed += take;
+        bytes += take;
+        size -= take;
+        if (blockUsed < sizeof(block)) {
+            return;
+        }
+        processBlock(block);
+        blockUsed = 0;
+    }
+
+    while (size >= sizeof(block)) {
+        processBlock(bytes);
+        bytes += sizeof(block);
+        size -= sizeof(block);
+    }
+
+    std::memcpy(block, bytes, size);
+    blockUsed = size;
+}
+
+void Sha1::final(unsigned char* digest) {
+    uint64_t totalBits = totalBytes * 8;
+
+    // Дополнение: 0x80, нули и длина сообщения в битах (big-endian)
+    unsigned char padding[72] = {0x80};
+    size_t padSize = (blockUsed < 56 ? 56 : 120) - blockUsed;
+    for (int i = 0; i < 8; i++) {
+        padding[padSize + i] = static_cast<unsigned char>(totalBits >> (56 - i * 8));
+    }
+    update(padding, padSize + 8);
+
+    for (int i = 0; i < 5; i++) {
+        digest[i * 4] = static_cast<unsigned char>(state[i] >> 24);
+        digest[i * 4 + 1] = static_cast<unsigned char>(state[i] >> 16);
+        digest[i * 4 + 2] = static_cast<unsigned char>(state[i] >> 8);
+        digest[i * 4 + 3] = static_cast<unsigned char>(state[i]);
+    }
+}
+
+void Sha1::hash(const void* data, size_t size, unsigned char* digest) {
+    Sha1 sha;
+    sha.update(data, size);
+    sha.final(digest);
+}
@@ -0,0 +1,28 @@
+#include <cstddef>
+#include <cstdint>
+
+#ifndef SHA1_HPP
+#define SHA1_HPP
+
+// Потоковый SHA-1 для проверки контрольных сумм файлов git
+class Sha1 {
+private:
+    uint32_t state[5];
+    uint64_t totalBytes = 0;
+    unsigned char block[64];
+    size_t blockUsed = 0;
+
+    void processBlock(const unsigned char* data);
+
+public:
+    Sha1();
+
+    void update(const void* data, size_t size);
+
+    // Записывает 20 байт хеша; после вызова объект использовать нельзя
+    void final(unsigned char* digest);
+
+    static void hash(const void* data, size_t size, unsigned char* digest);
+};
+
+#endif
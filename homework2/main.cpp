@@ -1,12 +1,19 @@
 #include <iostream>
 #include <filesystem>
+#include <memory>
+#include "CommitCache.hpp"
+#include "CommitGraph.hpp"
+#include "CommitGraphWriter.hpp"
 #include "GitIdxParser.hpp"
+#include "GraphRenderer.hpp"
+#include "HistoryWalk.hpp"
+#include "LooseObjectStore.hpp"
+#include "PackSet.hpp"
+#include "PlantUmlPipe.hpp"
 #include "inicpp.hpp"
 
 int main()
 {
-    std::string IdxFilePath, PackFilePath;
-
     if (!std::filesystem::exists("config.ini"))
     {
         std::cerr << "Отсутствует конфигурационный файл!\n";
@@ -15,28 +22,131 @@ int main()
 
     inicpp::IniManager ini("config.ini");
 
-    if (!ini["options"].isKeyExist("plantuml_jar_path") || !ini["options"].isKeyExist("repo_path") || !ini["options"].isKeyExist("output_path") || !ini["options"].isKeyExist("date"))
+    // PlantUML нужен, только если он выбран вместо встроенной отрисовки
+    std::string renderer = ini["options"].isKeyExist("renderer") ? ini["options"]["renderer"] : "native";
+    bool usePlantUml = renderer == "plantuml" || renderer == "plantuml_pipe";
+    if ((usePlantUml && !ini["options"].isKeyExist("plantuml_jar_path")) || !ini["options"].isKeyExist("repo_path") || !ini["options"].isKeyExist("output_path") || !ini["options"].isKeyExist("date"))
     {
         std::cerr << "Ошибка в конфигурационном файле!\n";
         return -1;
     }
 
-    for (const auto & entry : std::filesystem::directory_iterator(ini["options"]["repo_path"] + ".git/objects/pack"))
-    {
-        if (entry.path().extension() == ".idx")
-            IdxFilePath = std::filesystem::absolute(entry.path());
-
-        else if (entry.path().extension() == ".pack")
-            PackFilePath = std::filesystem::absolute(entry.path());
-    }
+    // Необязательные параметры
+    ExtractOptions options;
+    if (ini["options"].isKeyExist("delta_cache_mb"))
+        options.deltaCacheLimit = static_cast<size_t>(ini["options"].toInt("delta_cache_mb")) * 1024 * 1024;
+    if (ini["options"].isKeyExist("threads"))
+        options.threads = static_cast<unsigned>(ini["options"].toInt("threads"));
+    if (ini["options"].isKeyExist("bulk"))
+        options.bulk = ini["options"].toInt("bulk") != 0;
+    if (ini["options"].isKeyExist("stats"))
+        options.printStats = ini["options"].toInt("stats") != 0;
+    if (ini["options"].isKeyExist("compose_deltas"))
+        options.composeDeltas = ini["options"].toInt("compose_deltas") != 0;
+    bool walkRefs = ini["options"].isKeyExist("walk") && ini["options"].toInt("walk") != 0;
 
     try {
-        GitIdxParser parser;
-        if (parser.parseFile(IdxFilePath)) {
-            parser.extractCommitsToPuml(PackFilePath, ini["options"].toInt("date"), ini["options"]["output_path"]);
-            std::string outputFile = parser.convertPumlToPng(ini["options"]["plantuml_jar_path"]);
+        // Все pack файлы репозитория, а не только последний найденный
+        PackSet packs(ini["options"]["repo_path"] + ".git/objects/pack");
+
+        // Распаковщик объектов pack файлов выбирается из подключённых при сборке,
+        // до первой распаковки, в том числе при построении commit-graph
+        if (ini["options"].isKeyExist("decompressor"))
+        {
+            Decompressor::Backend backend;
+            if (!Decompressor::parseBackend(ini["options"]["decompressor"], backend))
+            {
+                std::cerr << "Неизвестный распаковщик: " << ini["options"]["decompressor"] << "\n";
+                return -1;
+            }
+            packs.setDecompressor(backend);
+        }
+
+        // Коммиты из commit-graph не распаковываются вовсе. Если у репозитория
+        // его нет, граф строится один раз и хранится в каталоге кэша
+        CommitGraph graph;
+        if (graph.load(ini["options"]["repo_path"] + ".git/objects"))
+            options.commitGraph = &graph;
+        else if (ini["options"].isKeyExist("commit_graph_cache") &&
+                 CommitGraphWriter::loadCached(packs, ini["options"]["commit_graph_cache"], graph, options.threads))
+            options.commitGraph = &graph;
+
+        // Скорость распаковки тех же pack файлов каждым подключённым распаковщиком
+        if (ini["options"].isKeyExist("benchmark") && ini["options"].toInt("benchmark") != 0)
+            for (Decompressor::Backend backend : Decompressor::availableBackends())
+                GitPackParser::printInflateBenchmark(backend, packs.benchmarkInflate(backend));
+
+        // Скорость наложения дельт без распаковки и кэша баз
+        if (ini["options"].isKeyExist("benchmark_delta") && ini["options"].toInt("benchmark_delta") != 0)
+            GitPackParser::printDeltaBenchmark(packs.benchmarkDelta());
+
+        // Точные размеры сжатых объектов по обратным индексам pack файлов
+        if (ini["options"].isKeyExist("pack_stats") && ini["options"].toInt("pack_stats") != 0)
+            GitPackParser::printSizeStats(packs.sizeStatistics());
+
+        // Свежие коммиты, ещё не упакованные git gc
+        LooseObjectStore loose(ini["options"]["repo_path"] + ".git/objects");
+
+        std::vector<CommitRecord> commits;
+        if (walkRefs)
+        {
+            // Только коммиты, достижимые из ссылок, от новых к старым до границы date
+            HistoryWalk walk({&packs, &loose}, options.commitGraph);
+            commits = walk.collectCommits(HistoryWalk::readRefs(ini["options"]["repo_path"] + ".git"),
+                                          ini["options"].toInt("date"));
+        }
+        else
+        {
+            // Повторный запуск разбирает только новые pack файлы и отдельные объекты
+            std::unique_ptr<CommitCache> resultCache;
+            if (ini["options"].isKeyExist("result_cache"))
+            {
+                resultCache = std::make_unique<CommitCache>(ini["options"]["result_cache"]);
+                options.resultCache = resultCache.get();
+            }
+
+            DeltaBaseCache::Stats stats;
+            commits = packs.collectCommits(ini["options"].toInt("date"), options, &stats);
+            std::vector<CommitRecord> looseCommits = loose.collectCommits(ini["options"].toInt("date"), options);
+            commits.insert(commits.end(), looseCommits.begin(), looseCommits.end());
+            GitIdxParser::sortUniqueCommits(commits);
+            if (options.printStats)
+            {
+                GitIdxParser::printCacheStats(stats);
+                if (resultCache)
+                    std::cerr << "Кэш результатов: pack файлов из кэша " << resultCache->packStats.hits
+                              << ", разобрано " << resultCache->packStats.misses
+                              << "; отдельных объектов из кэша " << resultCache->looseStats.hits
+                              << ", разобрано " << resultCache->looseStats.misses << "\n";
+            }
+        }
+
+        std::string pumlFile = GitIdxParser::writeCommitsToPuml(commits, ini["options"]["output_path"]);
+        if (usePlantUml)
+        {
+            std::string outputFile;
+            if (renderer == "plantuml_pipe")
+            {
+                PlantUmlPipe pipe(PlantUmlPipe::plantUmlCommand(ini["options"]["plantuml_jar_path"]));
+                outputFile = GitIdxParser::convertPumlToPng(pumlFile, pipe);
+            }
+            else
+                outputFile = GitIdxParser::convertPumlToPng(pumlFile, ini["options"]["plantuml_jar_path"]);
             std::cout << "PNG файл успешно создан: " << outputFile << "\n";
         }
+        else
+        {
+            GraphLayout layout = GraphRenderer::layout(commits);
+            std::string svgFile = ini["options"]["output_path"] + "commits.svg";
+            GraphRenderer::writeSvg(layout, commits, svgFile);
+            std::cout << "SVG файл успешно создан: " << svgFile << "\n";
+            if (!ini["options"].isKeyExist("png") || ini["options"].toInt("png") != 0)
+            {
+                std::string pngFile = ini["options"]["output_path"] + "commits.png";
+                GraphRenderer::writePng(layout, commits, pngFile);
+                std::cout << "PNG файл успешно создан: " << pngFile << "\n";
+            }
+        }
     } catch (const std::exception& e) {
         std::cerr << "Ошибка: " << e.what() << std::endl;
         return 1;
@@ -0,0 +1,35 @@
+#!/bin/sh
+# Заглушка PlantUML для тестов: тот же протокол -pipe, но без Java.
+# На каждый документ печатает "image <номер> <строк>", затем size символов x,
+# если в документе была строка "' size N", и строку-разделитель
+delimiter=""
+while [ $# -gt 0 ]; do
+    if [ "$1" = "-pipedelimitor" ]; then
+        delimiter="$2"
+        shift
+    fi
+    shift
+done
+
+n=0
+lines=0
+size=0
+while IFS= read -r line; do
+    lines=$((lines + 1))
+    case "$line" in
+        "' size "*)
+            size=${line#"' size "}
+            ;;
+        @enduml*)
+            n=$((n + 1))
+            echo "image $n $lines"
+            if [ "$size" -gt 0 ]; then
+                head -c "$size" /dev/zero | tr '\0' x
+                echo
+            fi
+            echo "$delimiter"
+            lines=0
+            size=0
+            ;;
+    esac
+done
@@ -1,31 +1,70 @@
 #define BOOST_TEST_MODULE GitIdxParserTest
+#include "CommitCache.hpp"
+#include "CommitGraph.hpp"
+#include "CommitGraphWriter.hpp"
+#include "CommitHeader.hpp"
+#include "Decompressor.hpp"
+#include "Delta.hpp"
 #include "GitIdxParser.hpp"
 #include "GitPackParser.hpp"
+#include "GraphRenderer.hpp"
+#include "HistoryWalk.hpp"
+#include "LooseObjectStore.hpp"
+#include "MultiPackIndex.hpp"
+#include "PackReverseIndex.hpp"
+#include "PackSet.hpp"
+#include "PlantUmlPipe.hpp"
+#include "ParallelFor.hpp"
 #include <boost/test/included/unit_test.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <zlib.h>
 
 GitIdxParser test;
 
 BOOST_AUTO_TEST_SUITE(GitIdxParserTestSuite)
 
-BOOST_AUTO_TEST_CASE(TestFindUnixTimestamp_ValidInput) {
-    std::string input = "Commit 1234567890";
-    int result = test.find_unix_timestamp(input);
-    BOOST_CHECK_EQUAL(result, 1234567890);
-}
-
-BOOST_AUTO_TEST_CASE(TestFindUnixTimestamp_InvalidInput) {
-    std::string input = "Commit abcdefghij";
-    int result = test.find_unix_timestamp(input);
-    BOOST_CHECK_EQUAL(result, -1);
-}
-
 BOOST_AUTO_TEST_CASE(TestBytesToHex) {
     unsigned char bytes[] = {0xDE, 0xAD, 0xBE, 0xEF};
     std::string result = test.bytesToHex(bytes, 4);
     BOOST_CHECK_EQUAL(result, "deadbeef");
 }
 
+BOOST_AUTO_TEST_CASE(TestReadObjectAtOffset_CorruptSizeHeader) {
+    std::string text = "hello\n";
+    std::vector<uint8_t> compressed(compressBound(text.size()));
+    uLongf compressedSize = compressed.size();
+    BOOST_REQUIRE_EQUAL(compress(compressed.data(), &compressedSize, reinterpret_cast<const Bytef*>(text.data()),
+                                 text.size()), Z_OK);
+    std::string packPath = (std::filesystem::temp_directory_path() / "graphviz_bad_size.pack").string();
+
+    // Размер в десять байт продолжения не уместить в 64 бита; 2^38 байт не
+    // получить из семи байт сжатых данных
+    std::vector<std::vector<uint8_t>> headers = {
+        {0xB6, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x01},
+        {0xB0, 0x80, 0x80, 0x80, 0x80, 0x40},
+    };
+    for (const std::vector<uint8_t>& header : headers) {
+        std::vector<uint8_t> bytes = {'P', 'A', 'C', 'K', 0, 0, 0, 2, 0, 0, 0, 1};
+        bytes.insert(bytes.end(), header.begin(), header.end());
+        bytes.insert(bytes.end(), compressed.begin(), compressed.begin() + compressedSize);
+        bytes.insert(bytes.end(), 20, 0);
+        std::ofstream(packPath, std::ios::binary).write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+
+        for (bool useMmap : {true, false}) {
+            GitPackParser corrupt(packPath, useMmap);
+            BOOST_CHECK_THROW(corrupt.readObjectAtOffset(12), std::runtime_error);
+            BOOST_CHECK_THROW(corrupt.getObjectContent(12), std::runtime_error);
+        }
+    }
+    std::filesystem::remove(packPath);
+}
+
 BOOST_AUTO_TEST_CASE(TestReadExactly_Success) {
     std::ofstream tempFile("test.bin", std::ios::binary);
     char buffer[] = "test";
@@ -103,6 +142,18 @@ BOOST_AUTO_TEST_CASE(TestReadObjectAtOffset_InvalidOffset) {
     BOOST_CHECK_THROW(parser.readObjectAtOffset(invalidOffset), std::runtime_error);
 }
 
+BOOST_AUTO_TEST_CASE(TestReadObjectAtOffset_BlobContent) {
+    PackedObject obj = parser.readObjectAtOffset(12);
+    BOOST_CHECK(obj.type == GitObjectType::BLOB);
+    BOOST_CHECK_EQUAL(std::string(obj.data.begin(), obj.data.end()), "hello\n");
+}
+
+BOOST_AUTO_TEST_CASE(TestReadObjectAtOffset_PreadFallback) {
+    GitPackParser preadParser(mockPackPath, false);
+    PackedObject obj = preadParser.readObjectAtOffset(12);
+    BOOST_CHECK_EQUAL(std::string(obj.data.begin(), obj.data.end()), "hello\n");
+}
+
 BOOST_AUTO_TEST_CASE(TestReadExactly_Success) {
     char buffer[4];
     BOOST_CHECK(parser.readExactly(buffer, 4));
@@ -119,20 +170,1422 @@ BOOST_AUTO_TEST_CASE(TestReadVariableLengthNumber_Valid) {
 }
 
 BOOST_AUTO_TEST_SUITE_END()
+
+const std::string mockDeltaPackPath = "mock_delta.pack";
+
+// Смещения в mock_delta.pack: цепочка дельт 1883 -> 1794 -> 1548 -> 1385 -> 1116
+const uint64_t deltaChainTip = 1883;
+const uint64_t deltaChainRoot = 1116;
+
+BOOST_AUTO_TEST_CASE(TestDeltaBaseCache_EvictsLeastRecentlyUsed) {
+    DeltaBaseCache cache(10);
+    auto chunk = [](size_t size) { return std::make_shared<const std::vector<uint8_t>>(size); };
+    GitObjectType type;
+
+    cache.put(1, GitObjectType::BLOB, chunk(4));
+    cache.put(2, GitObjectType::BLOB, chunk(4));
+    BOOST_CHECK(cache.get(1, type));
+    cache.put(3, GitObjectType::TREE, chunk(4));
+
+    BOOST_CHECK(cache.get(1, type));
+    BOOST_CHECK(!cache.get(2, type));
+    BOOST_CHECK(cache.get(3, type) && type == GitObjectType::TREE);
+    BOOST_CHECK_EQUAL(cache.memoryUsage(), 8u);
+    BOOST_CHECK_EQUAL(cache.statistics().evictions, 1u);
+    BOOST_CHECK_EQUAL(cache.statistics().misses, 1u);
+}
+
+BOOST_AUTO_TEST_CASE(TestDeltaBaseCache_SkipsObjectsOverBudget) {
+    DeltaBaseCache cache(10);
+    GitObjectType type;
+    cache.put(1, GitObjectType::BLOB, std::make_shared<const std::vector<uint8_t>>(11));
+    BOOST_CHECK(!cache.get(1, type));
+    BOOST_CHECK_EQUAL(cache.memoryUsage(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(TestDeltaBaseCache_ShardsShareBudget) {
+    // База больше доли одного сегмента всё равно кэшируется и вытесняет
+    // записи других сегментов, а общий бюджет не превышается
+    DeltaBaseCache cache(100, 16);
+    auto chunk = [](size_t size) { return std::make_shared<const std::vector<uint8_t>>(size); };
+    GitObjectType type;
+    for (uint64_t offset = 0; offset < 10; offset++) {
+        cache.put(offset, GitObjectType::BLOB, chunk(10));
+    }
+    BOOST_CHECK_EQUAL(cache.memoryUsage(), 100u);
+
+    cache.put(1000, GitObjectType::BLOB, chunk(90));
+    BOOST_CHECK(cache.get(1000, type));
+    BOOST_CHECK_LE(cache.memoryUsage(), 100u);
+    BOOST_CHECK_EQUAL(cache.statistics().evictions, 9u);
+}
+
+BOOST_AUTO_TEST_CASE(TestDeltaBaseCache_ConcurrentPutsKeepBudget) {
+    // Потоки вытесняют записи чужих сегментов одновременно, но вставка
+    // всё равно не выходит за общий бюджет
+    DeltaBaseCache cache(100, 4);
+    std::atomic<bool> overBudget{false};
+    std::vector<std::thread> threads;
+    for (uint64_t t = 0; t < 4; t++) {
+        threads.emplace_back([&cache, &overBudget, t] {
+            for (uint64_t i = 0; i < 20000; i++) {
+                cache.put(t * 1000000 + i, GitObjectType::BLOB, std::make_shared<const std::vector<uint8_t>>(30 + i % 40));
+                if (cache.memoryUsage() > 100) {
+                    overBudget = true;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    BOOST_CHECK(!overBudget);
+    BOOST_CHECK_LE(cache.memoryUsage(), 100u);
+}
+
+BOOST_AUTO_TEST_CASE(TestGetObjectContent_DeltaChainUsesCache) {
+    GitPackParser parser(mockDeltaPackPath);
+    auto [type, content] = parser.getObjectContent(deltaChainTip);
+    BOOST_CHECK(type == GitObjectType::BLOB);
+    BOOST_CHECK_EQUAL(content.size(), 453u);
+    std::string text(content.begin(), content.end());
+    BOOST_CHECK(text.find("changed in commit 1 with some extra words 00000") != std::string::npos);
+
+    uint64_t hitsBefore = parser.deltaBaseCache().statistics().hits;
+    auto [againType, againContent] = parser.getObjectContent(deltaChainTip);
+    BOOST_CHECK(againContent == content);
+    BOOST_CHECK_GT(parser.deltaBaseCache().statistics().hits, hitsBefore);
+}
+
+BOOST_AUTO_TEST_CASE(TestGetObjectContent_DeltaChainWithoutCache) {
+    GitPackParser cached(mockDeltaPackPath);
+    GitPackParser uncached(mockDeltaPackPath);
+    uncached.deltaBaseCache().setMemoryLimit(0);
+
+    BOOST_CHECK(cached.getObjectContent(deltaChainTip).second == uncached.getObjectContent(deltaChainTip).second);
+    BOOST_CHECK(cached.getObjectContent(deltaChainRoot).second == uncached.getObjectContent(deltaChainRoot).second);
+    BOOST_CHECK_EQUAL(uncached.deltaBaseCache().statistics().hits, 0u);
+}
+
+// SHA-1 блоба на вершине цепочки дельт
+const std::string deltaChainTipSha = "2ce3d7ad289a70b182ab06f5e043a72737a0ee8f";
+
+BOOST_AUTO_TEST_CASE(TestFindOffset_KnownAndMissingObjects) {
+    GitIdxParser idx;
+    BOOST_REQUIRE(idx.parseFile("mock_delta.idx"));
+
+    unsigned char sha1[20];
+    BOOST_REQUIRE(GitIdxParser::hexToBytes(deltaChainTipSha, sha1));
+    uint64_t offset = 0;
+    BOOST_CHECK(idx.findOffset(sha1, offset));
+    BOOST_CHECK_EQUAL(offset, deltaChainTip);
+
+    sha1[19] ^= 0xFF;
+    BOOST_CHECK_EQUAL(idx.findObject(sha1), -1);
+    BOOST_CHECK(!GitIdxParser::hexToBytes("not a sha", sha1));
+}
+
+BOOST_AUTO_TEST_CASE(TestMapFile_MatchesParseFile) {
+    GitIdxParser loaded, mapped;
+    BOOST_REQUIRE(loaded.parseFile("mock_delta.idx"));
+    BOOST_REQUIRE(mapped.mapFile("mock_delta.idx", true));
+
+    BOOST_REQUIRE_EQUAL(mapped.objectCount(), loaded.objectCount());
+    for (size_t i = 0; i < loaded.objectCount(); i++) {
+        BOOST_CHECK_EQUAL(mapped.hexAt(i), loaded.hexAt(i));
+        BOOST_CHECK_EQUAL(mapped.offsetAt(i), loaded.offsetAt(i));
+        BOOST_CHECK_EQUAL(mapped.crc32At(i), loaded.crc32At(i));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(TestParseFile_ChecksumMismatch) {
+    std::ifstream source("mock_delta.idx", std::ios::binary);
+    std::string bytes((std::istreambuf_iterator<char>(source)), std::istreambuf_iterator<char>());
+    bytes[1040] ^= 0x01;  // байт в таблице SHA-1
+    std::ofstream("corrupt.idx", std::ios::binary) << bytes;
+
+    GitIdxParser idx;
+    BOOST_CHECK(idx.parseFile("corrupt.idx"));
+    BOOST_CHECK(!idx.parseFile("corrupt.idx", true));
+    BOOST_CHECK(!idx.mapFile("corrupt.idx", true));
+    std::filesystem::remove("corrupt.idx");
+}
+
+// Индекс из двух объектов; второй ссылается на таблицу 64-битных смещений
+void writeLargeOffsetIdx(const std::string& path, uint32_t secondOffset) {
+    std::string bytes;
+    auto put32 = [&bytes](uint32_t value) {
+        for (int shift = 24; shift >= 0; shift -= 8) bytes.push_back(static_cast<char>(value >> shift));
+    };
+    put32(0xFF744F63);
+    put32(2);
+    for (int i = 0; i < 256; i++) put32(i == 0 ? 0 : (i == 1 ? 1 : 2));
+    for (int object = 1; object <= 2; object++) {
+        bytes.push_back(static_cast<char>(object));
+        bytes.append(19, '\0');
+    }
+    put32(0);
+    put32(0);
+    put32(12);
+    put32(secondOffset);
+    put32(0x3);
+    put32(0x0);
+    bytes.append(40, '\0');
+    std::ofstream(path, std::ios::binary) << bytes;
+}
+
+BOOST_AUTO_TEST_CASE(TestOffsetAt_LargeOffsetTable) {
+    writeLargeOffsetIdx("large.idx", 0x80000000);
+    GitIdxParser idx;
+    BOOST_REQUIRE(idx.mapFile("large.idx"));
+    BOOST_CHECK_EQUAL(idx.offsetAt(0), 12u);
+    BOOST_CHECK_EQUAL(idx.offsetAt(1), 0x300000000ull);
+
+    unsigned char sha1[20] = {0x02};
+    uint64_t offset = 0;
+    BOOST_CHECK(idx.findOffset(sha1, offset));
+    BOOST_CHECK_EQUAL(offset, 0x300000000ull);
+
+    writeLargeOffsetIdx("large.idx", 0x80000001);
+    BOOST_REQUIRE(idx.parseFile("large.idx"));
+    BOOST_CHECK_THROW(idx.offsetAt(1), std::runtime_error);
+    std::filesystem::remove("large.idx");
+}
+
+BOOST_AUTO_TEST_CASE(TestParallelFor_VisitsEveryIndexOnce) {
+    std::vector<std::atomic<int>> visits(1000);
+    parallelFor(visits.size(), 4, 7, [&](unsigned, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) visits[i]++;
+    });
+    BOOST_CHECK(std::all_of(visits.begin(), visits.end(), [](const std::atomic<int>& v) { return v == 1; }));
+
+    BOOST_CHECK_THROW(parallelFor(10, 2, 1, [](unsigned, size_t begin, size_t) {
+        if (begin == 5) throw std::runtime_error("fail");
+    }), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(TestCollectCommits_ParallelMatchesSerial) {
+    GitIdxParser idx;
+    BOOST_REQUIRE(idx.mapFile("mock_delta.idx"));
+
+    ExtractOptions serial, parallel;
+    parallel.threads = 4;
+    std::vector<CommitRecord> expected = idx.collectCommits(mockDeltaPackPath, 0, serial);
+    std::vector<CommitRecord> actual = idx.collectCommits(mockDeltaPackPath, 0, parallel);
+
+    BOOST_REQUIRE(!expected.empty());
+    BOOST_REQUIRE_EQUAL(actual.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); i++) {
+        BOOST_CHECK(std::equal(actual[i].id, actual[i].id + 20, expected[i].id));
+        BOOST_CHECK(actual[i].parents == expected[i].parents);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(TestGetObjectContent_SharedBetweenThreads) {
+    GitIdxParser idx;
+    BOOST_REQUIRE(idx.mapFile("mock_delta.idx"));
+    const GitPackParser shared(mockDeltaPackPath);
+
+    std::vector<std::vector<uint8_t>> expected;
+    for (size_t i = 0; i < idx.objectCount(); i++) {
+        expected.push_back(GitPackParser(mockDeltaPackPath).getObjectContent(idx.offsetAt(i)).second);
+    }
+
+    std::atomic<int> mismatches{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&, t]() {
+            for (int round = 0; round < 50; round++) {
+                size_t i = (round * 7 + t) % idx.objectCount();
+                if (shared.getObjectContent(idx.offsetAt(i)).second != expected[i]) mismatches++;
+            }
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+    BOOST_CHECK_EQUAL(mismatches.load(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(TestForEachObject_VisitsEveryObjectOnce) {
+    for (const std::string name : {"mock_delta", "mock_refdelta"}) {
+        GitIdxParser idx;
+        BOOST_REQUIRE(idx.mapFile(name + ".idx"));
+        GitPackParser parser(name + ".pack");
+        parser.setIndex(&idx);
+
+        std::vector<uint64_t> offsets;
+        for (size_t i = 0; i < idx.objectCount(); i++) {
+            offsets.push_back(idx.offsetAt(i));
+        }
+
+        std::vector<int> visits(offsets.size());
+        std::vector<std::vector<uint8_t>> contents(offsets.size());
+        parser.forEachObject(offsets, [&](size_t item, GitObjectType, const std::vector<uint8_t>& content) {
+            visits[item]++;
+            contents[item] = content;
+        });
+
+        for (size_t i = 0; i < offsets.size(); i++) {
+            BOOST_CHECK_EQUAL(visits[i], 1);
+            BOOST_CHECK(contents[i] == parser.getObjectContent(offsets[i]).second);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(TestForEachObject_DuplicateOffsetsVisitedForEachItem) {
+    GitPackParser parser(mockDeltaPackPath);
+    std::vector<int> visits(3);
+    parser.forEachObject({deltaChainTip, deltaChainRoot, deltaChainTip},
+                         [&](size_t item, GitObjectType, const std::vector<uint8_t>&) { visits[item]++; });
+    BOOST_CHECK(visits == std::vector<int>({1, 1, 1}));
+}
+
+// Копия mock_delta.pack, в которой испорчены сжатые данные одного коммита
+static void writeCorruptDeltaPack(const GitIdxParser& idx, const std::string& path) {
+    GitPackParser original(mockDeltaPackPath);
+    uint64_t commitData = 0;
+    for (size_t i = 0; i < idx.objectCount() && !commitData; i++) {
+        PackedObject header = original.readObjectHeader(idx.offsetAt(i));
+        if (header.type == GitObjectType::COMMIT) {
+            commitData = header.dataOffset;
+        }
+    }
+    BOOST_REQUIRE(commitData);
+    std::ifstream in(mockDeltaPackPath, std::ios::binary);
+    std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    bytes[commitData + 4] ^= 0xFF;
+    std::ofstream(path, std::ios::binary) << bytes;
+}
+
+BOOST_AUTO_TEST_CASE(TestCollectCommits_BulkSkipsCorruptObject) {
+    GitIdxParser idx;
+    BOOST_REQUIRE(idx.mapFile("mock_delta.idx"));
+    std::vector<CommitRecord> intact = idx.collectCommits(mockDeltaPackPath, 0);
+    std::string corruptPack = (std::filesystem::temp_directory_path() / "graphviz_corrupt.pack").string();
+    writeCorruptDeltaPack(idx, corruptPack);
+
+    ExtractOptions bulk;
+    bulk.bulk = true;
+    size_t serialFailures = 0;
+    size_t batchedFailures = 0;
+    std::vector<CommitRecord> serial = idx.collectCommits(corruptPack, 0, {}, nullptr, &serialFailures);
+    std::vector<CommitRecord> batched;
+    BOOST_CHECK_NO_THROW(batched = idx.collectCommits(corruptPack, 0, bulk, nullptr, &batchedFailures));
+    BOOST_CHECK_EQUAL(serialFailures, 1u);
+    BOOST_CHECK_EQUAL(batchedFailures, 1u);
+    BOOST_CHECK_EQUAL(serial.size(), intact.size() - 1);
+    BOOST_REQUIRE_EQUAL(batched.size(), serial.size());
+    for (size_t i = 0; i < serial.size(); i++) {
+        BOOST_CHECK(std::equal(batched[i].id, batched[i].id + 20, serial[i].id));
+    }
+    std::filesystem::remove(corruptPack);
+}
+
+BOOST_AUTO_TEST_CASE(TestForEachObject_BaseOutsideList) {
+    GitPackParser parser(mockDeltaPackPath);
+    std::vector<uint8_t> content;
+    parser.forEachObject({deltaChainTip}, [&](size_t item, GitObjectType type, const std::vector<uint8_t>& data) {
+        BOOST_CHECK_EQUAL(item, 0u);
+        BOOST_CHECK(type == GitObjectType::BLOB);
+        content = data;
+    });
+    BOOST_CHECK(content == parser.getObjectContent(deltaChainTip).second);
+}
+
+BOOST_AUTO_TEST_CASE(TestPeekTypeAndSize_MatchFullDecode) {
+    for (const std::string name : {"mock_delta", "mock_refdelta"}) {
+        GitIdxParser idx;
+        BOOST_REQUIRE(idx.mapFile(name + ".idx"));
+        GitPackParser parser(name + ".pack");
+        parser.setIndex(&idx);
+
+        for (size_t i = 0; i < idx.objectCount(); i++) {
+            auto [type, content] = parser.getObjectContent(idx.offsetAt(i));
+            BOOST_CHECK(parser.peekType(idx.offsetAt(i)) == type);
+            BOOST_CHECK_EQUAL(parser.peekSize(idx.offsetAt(i)), content.size());
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(TestGetObjectContent_RefDelta) {
+    GitIdxParser idx;
+    BOOST_REQUIRE(idx.parseFile("mock_refdelta.idx"));
+    unsigned char sha1[20];
+    GitIdxParser::hexToBytes(deltaChainTipSha, sha1);
+    uint64_t offset = 0;
+    BOOST_REQUIRE(idx.findOffset(sha1, offset));
+
+    GitPackParser refParser("mock_refdelta.pack");
+    BOOST_CHECK_THROW(refParser.getObjectContent(offset), std::runtime_error);
+
+    refParser.setIndex(&idx);
+    GitPackParser ofsParser(mockDeltaPackPath);
+    BOOST_CHECK(refParser.getObjectContent(offset).second == ofsParser.getObjectContent(deltaChainTip).second);
+}
+
+BOOST_AUTO_TEST_CASE(TestGetObjectContent_RefDeltaCycle) {
+    GitIdxParser idx;
+    BOOST_REQUIRE(idx.parseFile("mock_refdelta.idx"));
+    unsigned char sha1[20];
+    GitIdxParser::hexToBytes(deltaChainTipSha, sha1);
+    uint64_t offset = 0;
+    BOOST_REQUIRE(idx.findOffset(sha1, offset));
+
+    // База REF_DELTA заменяется на сам объект: цепочка замыкается на себя
+    PackedObject header = GitPackParser("mock_refdelta.pack").readObjectHeader(offset);
+    BOOST_REQUIRE(header.type == GitObjectType::REF_DELTA);
+    std::ifstream in("mock_refdelta.pack", std::ios::binary);
+    std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::copy(sha1, sha1 + 20, bytes.begin() + (header.dataOffset - 20));
+    std::string cyclePack = (std::filesystem::temp_directory_path() / "graphviz_refcycle.pack").string();
+    std::ofstream(cyclePack, std::ios::binary) << bytes;
+
+    {
+        GitPackParser parser(cyclePack);
+        parser.setIndex(&idx);
+        BOOST_CHECK_THROW(parser.getObjectContent(offset), std::runtime_error);
+        BOOST_CHECK_THROW(parser.getObjectContent(offset, true), std::runtime_error);
+        BOOST_CHECK_THROW(parser.peekType(offset), std::runtime_error);
+    }
+    std::filesystem::remove(cyclePack);
+}
+
+// mock_packs: три pack файла, multi-pack-index покрывает два из них
+static const std::string mockPacksDir = "mock_packs";
+static const std::string rootCommitSha = "22ae6f04f1f3d73122f1e288419ff12bbe28bde8";
+static const std::string uncoveredCommitSha = "32e14f3a5dcc589409f81687bb1868636f7a3380";
+
+BOOST_AUTO_TEST_CASE(TestMultiPackIndex_Lookup) {
+    MultiPackIndex midx;
+    BOOST_REQUIRE(midx.mapFile(mockPacksDir + "/multi-pack-index"));
+    BOOST_REQUIRE_EQUAL(midx.packs().size(), 2u);
+    BOOST_CHECK_EQUAL(midx.objectCount(), 18u);
+
+    unsigned char sha1[20];
+    GitIdxParser::hexToBytes(rootCommitSha, sha1);
+    int64_t i = midx.findObject(sha1);
+    BOOST_REQUIRE(i >= 0);
+
+    GitIdxParser idx;
+    BOOST_REQUIRE(idx.mapFile(mockPacksDir + "/" + midx.packs()[midx.packAt(i)]));
+    uint64_t offset = 0;
+    BOOST_REQUIRE(idx.findOffset(sha1, offset));
+    BOOST_CHECK_EQUAL(midx.offsetAt(i), offset);
+
+    GitIdxParser::hexToBytes(uncoveredCommitSha, sha1);
+    BOOST_CHECK_EQUAL(midx.findObject(sha1), -1);
+}
+
+BOOST_AUTO_TEST_CASE(TestMultiPackIndex_RejectsOtherFiles) {
+    MultiPackIndex midx;
+    BOOST_CHECK(!midx.mapFile(mockDeltaPackPath));
+    BOOST_CHECK(!midx.isLoaded());
+}
+
+BOOST_AUTO_TEST_CASE(TestMultiPackIndex_TablesWithinTheirChunks) {
+    std::ifstream in(mockPacksDir + "/multi-pack-index", std::ios::binary);
+    std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    // Лишний объект в fanout: таблица SHA-1 выходит за свой блок, хотя
+    // следующий блок и не даёт ей выйти за конец файла
+    uint32_t chunkCount = static_cast<unsigned char>(bytes[6]);
+    for (uint32_t i = 0; i < chunkCount; i++) {
+        const char* entry = bytes.data() + 12 + i * 12;
+        if (std::string(entry, 4) == "OIDF") {
+            uint64_t begin = 0;
+            for (int k = 4; k < 12; k++) {
+                begin = (begin << 8) | static_cast<unsigned char>(entry[k]);
+            }
+            bytes[begin + 255 * 4 + 3]++;
+        }
+    }
+    std::string path = (std::filesystem::temp_directory_path() / "graphviz_short_oidl.midx").string();
+    std::ofstream(path, std::ios::binary) << bytes;
+
+    MultiPackIndex midx;
+    BOOST_CHECK(!midx.mapFile(path));
+    std::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(TestPackSet_SplitsCacheBudgetAcrossPacks) {
+    PackSet packs(mockPacksDir);
+    packs.setDeltaCacheLimit(3000);
+    unsigned char sha1[20];
+    GitIdxParser::hexToBytes(rootCommitSha, sha1);
+    GitObjectType type;
+    std::vector<uint8_t> content;
+    BOOST_REQUIRE(packs.readObject(sha1, type, content));
+
+    for (size_t i = 0; i < packs.packCount(); i++) {
+        if (const GitPackParser* parser = packs.packParser(i)) {
+            BOOST_CHECK_EQUAL(parser->deltaBaseCache().memoryLimitBytes(), 1000u);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(TestPackSet_OpensPacksLazily) {
+    PackSet packs(mockPacksDir);
+    BOOST_CHECK_EQUAL(packs.packCount(), 3u);
+    BOOST_CHECK(packs.hasMultiPackIndex());
+    BOOST_CHECK_EQUAL(packs.openedPackCount(), 0u);
+
+    // Объект из pack файла вне multi-pack-index
+    unsigned char sha1[20];
+    GitIdxParser::hexToBytes(uncoveredCommitSha, sha1);
+    BOOST_CHECK(packs.contains(sha1));
+    BOOST_CHECK_EQUAL(packs.openedPackCount(), 0u);
+
+    GitObjectType type;
+    std::vector<uint8_t> content;
+    BOOST_REQUIRE(packs.readObject(sha1, type, content));
+    BOOST_CHECK(type == GitObjectType::COMMIT);
+    BOOST_CHECK_EQUAL(packs.openedPackCount(), 1u);
+
+    GitIdxParser::hexToBytes(rootCommitSha, sha1);
+    BOOST_REQUIRE(packs.readObject(sha1, type, content));
+    BOOST_CHECK(type == GitObjectType::COMMIT);
+    BOOST_CHECK_EQUAL(packs.openedPackCount(), 2u);
+
+    std::memset(sha1, 0, sizeof(sha1));
+    BOOST_CHECK(!packs.readObject(sha1, type, content));
+}
+
+BOOST_AUTO_TEST_CASE(TestPackSet_CollectsCommitsFromAllPacks) {
+    PackSet packs(mockPacksDir);
+    std::vector<CommitRecord> commits = packs.collectCommits(0);
+
+    std::vector<std::string> ids;
+    for (const CommitRecord& commit : commits) {
+        ids.push_back(GitIdxParser::bytesToHex(commit.id, 20));
+    }
+    BOOST_CHECK(std::is_sorted(ids.begin(), ids.end()));
+    BOOST_CHECK(std::adjacent_find(ids.begin(), ids.end()) == ids.end());
+    BOOST_CHECK_EQUAL(ids.size(), 8u);
+    BOOST_CHECK(std::find(ids.begin(), ids.end(), uncoveredCommitSha) != ids.end());
+    BOOST_CHECK(std::find(ids.begin(), ids.end(), rootCommitSha) != ids.end());
+    BOOST_CHECK_EQUAL(packs.openedPackCount(), 3u);
+}
+
+// mock_loose: отдельные объекты двух коммитов и одного брошенного при amend
+static const std::string mockLooseDir = "mock_loose";
+static const std::string looseHeadSha = "773c4af43031690adb1d48fc7ce30caf454d40e3";
+
+BOOST_AUTO_TEST_CASE(TestLooseObjectStore_ReadObject) {
+    LooseObjectStore loose(mockLooseDir);
+    BOOST_CHECK_EQUAL(loose.listObjects(4).size(), 7u);
+
+    unsigned char sha1[20];
+    GitIdxParser::hexToBytes(looseHeadSha, sha1);
+    BOOST_CHECK(loose.contains(sha1));
+
+    GitObjectType type;
+    std::vector<uint8_t> content;
+    BOOST_REQUIRE(loose.readObject(sha1, type, content));
+    BOOST_CHECK(type == GitObjectType::COMMIT);
+    std::string text(content.begin(), content.end());
+    BOOST_CHECK_EQUAL(text.compare(0, 5, "tree "), 0);
+    BOOST_CHECK(text.find("parent d93a89d2bc30adda3f0f53233e6db9e3d94cb6e9") != std::string::npos);
+
+    GitObjectType peeked;
+    BOOST_REQUIRE(loose.peekType(sha1, peeked));
+    BOOST_CHECK(peeked == type);
+
+    std::memset(sha1, 0, sizeof(sha1));
+    BOOST_CHECK(!loose.contains(sha1));
+    BOOST_CHECK(!loose.readObject(sha1, type, content));
+}
+
+BOOST_AUTO_TEST_CASE(TestLooseObjectStore_ParallelCollectMatchesSerial) {
+    LooseObjectStore loose(mockLooseDir);
+    ExtractOptions serial;
+    ExtractOptions parallel;
+    parallel.threads = 4;
+
+    std::vector<CommitRecord> expected = loose.collectCommits(0, serial);
+    std::vector<CommitRecord> actual = loose.collectCommits(0, parallel);
+    BOOST_REQUIRE_EQUAL(actual.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); i++) {
+        BOOST_CHECK_EQUAL(std::memcmp(actual[i].id, expected[i].id, 20), 0);
+        BOOST_CHECK(actual[i].parents == expected[i].parents);
+    }
+
+    bool foundHead = false;
+    for (const CommitRecord& commit : expected) {
+        foundHead |= GitIdxParser::bytesToHex(commit.id, 20) == looseHeadSha;
+    }
+    BOOST_CHECK(foundHead);
+    BOOST_CHECK(loose.collectCommits(2000000000).empty());
+}
+
+// mock_graph и mock_graph_split: commit-graph для коммитов из mock_packs,
+// одним файлом и цепочкой из двух слоёв (c1..c4 и c5..c8)
+BOOST_AUTO_TEST_CASE(TestCommitGraph_SingleFileAndChainAgree) {
+    CommitGraph single;
+    BOOST_REQUIRE(single.load("mock_graph"));
+    BOOST_CHECK_EQUAL(single.layerCount(), 1u);
+    BOOST_CHECK_EQUAL(single.commitCount(), 8u);
+
+    CommitGraph split;
+    BOOST_REQUIRE(split.load("mock_graph_split"));
+    BOOST_CHECK_EQUAL(split.layerCount(), 2u);
+    BOOST_CHECK_EQUAL(split.commitCount(), 8u);
+
+    for (const CommitGraph* graph : {&single, &split}) {
+        unsigned char sha1[20];
+        GitIdxParser::hexToBytes(uncoveredCommitSha, sha1);
+        int64_t pos = graph->findCommit(sha1);
+        BOOST_REQUIRE(pos >= 0);
+        BOOST_CHECK_EQUAL(graph->commitTimeAt(pos), 1700000800u);
+        BOOST_CHECK_EQUAL(graph->generationAt(pos), 8u);
+
+        std::vector<uint64_t> parents;
+        graph->parentsAt(pos, parents);
+        BOOST_REQUIRE_EQUAL(parents.size(), 1u);
+        BOOST_CHECK_EQUAL(GitIdxParser::bytesToHex(graph->sha1At(parents[0]), 20),
+                          "f3ca7f8ee18de0ab94d66fc5c19afdc78b0eb749");
+
+        GitIdxParser::hexToBytes(rootCommitSha, sha1);
+        pos = graph->findCommit(sha1);
+        BOOST_REQUIRE(pos >= 0);
+        graph->parentsAt(pos, parents);
+        BOOST_CHECK(parents.empty());
+        BOOST_CHECK_EQUAL(graph->generationAt(pos), 1u);
+
+        GitIdxParser::hexToBytes(looseHeadSha, sha1);
+        BOOST_CHECK_EQUAL(graph->findCommit(sha1), -1);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(TestCommitGraph_MissingGraph) {
+    CommitGraph graph;
+    BOOST_CHECK(!graph.load(mockLooseDir));
+    BOOST_CHECK(!graph.isLoaded());
+}
+
+BOOST_AUTO_TEST_CASE(TestCommitGraph_CommitsTakenWithoutDecoding) {
+    CommitGraph graph;
+    BOOST_REQUIRE(graph.load("mock_graph_split"));
+    ExtractOptions options;
+    options.commitGraph = &graph;
+
+    for (bool bulk : {false, true}) {
+        options.bulk = bulk;
+        PackSet packs(mockPacksDir);
+        std::vector<CommitRecord> commits = packs.collectCommits(1700000300, options);
+        BOOST_REQUIRE_EQUAL(commits.size(), 6u);
+        for (const CommitRecord& commit : commits) {
+            int64_t pos = graph.findCommit(commit.id);
+            BOOST_REQUIRE(pos >= 0);
+            BOOST_CHECK_EQUAL(static_cast<uint64_t>(commit.time), graph.commitTimeAt(pos));
+            BOOST_CHECK_EQUAL(commit.parents.size(), 1u);
+        }
+
+        // Все объекты в pack файлах либо коммиты из графа, либо не коммиты:
+        // кэш баз дельт не понадобился ни разу
+        DeltaBaseCache::Stats stats;
+        packs.collectCommits(0, options, &stats);
+        BOOST_CHECK_EQUAL(stats.hits + stats.misses, 0u);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(TestCommitGraphWriter_MatchesGitGraph) {
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "graphviz_graph_cache";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    std::ofstream((dir / "commit-graph-stale.graph").string()) << "old";
+
+    PackSet packs(mockPacksDir);
+    CommitGraph written;
+    BOOST_REQUIRE(CommitGraphWriter::loadCached(packs, dir.string(), written));
+    BOOST_CHECK(!std::filesystem::exists(dir / "commit-graph-stale.graph"));
+    std::filesystem::path cached = dir / ("commit-graph-" + packs.fingerprint() + ".graph");
+    BOOST_REQUIRE(std::filesystem::exists(cached));
+
+    CommitGraph git;
+    BOOST_REQUIRE(git.load("mock_graph"));
+    BOOST_REQUIRE_EQUAL(written.commitCount(), git.commitCount());
+    for (uint64_t pos = 0; pos < git.commitCount(); pos++) {
+        BOOST_CHECK_EQUAL(std::memcmp(written.sha1At(pos), git.sha1At(pos), 20), 0);
+        BOOST_CHECK_EQUAL(std::memcmp(written.treeAt(pos), git.treeAt(pos), 20), 0);
+        BOOST_CHECK_EQUAL(written.commitTimeAt(pos), git.commitTimeAt(pos));
+        BOOST_CHECK_EQUAL(written.generationAt(pos), git.generationAt(pos));
+        std::vector<uint64_t> a, b;
+        written.parentsAt(pos, a);
+        git.parentsAt(pos, b);
+        BOOST_CHECK(a == b);
+    }
+
+    // Второй запуск читает готовый файл и не открывает pack файлы
+    PackSet again(mockPacksDir);
+    CommitGraph reused;
+    BOOST_REQUIRE(CommitGraphWriter::loadCached(again, dir.string(), reused));
+    BOOST_CHECK_EQUAL(again.openedPackCount(), 0u);
+    BOOST_CHECK_EQUAL(reused.commitCount(), 8u);
+    std::filesystem::remove_all(dir);
+}
+
+BOOST_AUTO_TEST_CASE(TestCommitGraphWriter_IncompleteGraphNotCached) {
+    std::filesystem::path packDir = std::filesystem::temp_directory_path() / "graphviz_corrupt_packs";
+    std::filesystem::path cacheDir = std::filesystem::temp_directory_path() / "graphviz_corrupt_graph_cache";
+    std::filesystem::remove_all(packDir);
+    std::filesystem::remove_all(cacheDir);
+    std::filesystem::create_directories(packDir);
+    GitIdxParser idx;
+    BOOST_REQUIRE(idx.mapFile("mock_delta.idx"));
+    std::filesystem::copy_file("mock_delta.idx", packDir / "pack-corrupt.idx");
+    writeCorruptDeltaPack(idx, (packDir / "pack-corrupt.pack").string());
+
+    PackSet packs(packDir.string());
+    CommitGraphWriter writer;
+    writer.addPacks(packs);
+    BOOST_CHECK_EQUAL(writer.decodeFailures(), 1u);
+
+    CommitGraph graph;
+    BOOST_CHECK(!CommitGraphWriter::loadCached(packs, cacheDir.string(), graph));
+    BOOST_CHECK(std::filesystem::is_empty(cacheDir));
+    std::filesystem::remove_all(packDir);
+    std::filesystem::remove_all(cacheDir);
+}
+
+BOOST_AUTO_TEST_CASE(TestCommitGraphWriter_OctopusAndMissingParents) {
+    auto id = [](unsigned char b) {
+        CommitGraphWriter::ObjectId value;
+        value.fill(b);
+        return value;
+    };
+    CommitGraphWriter writer;
+    writer.add({id(0x10), id(0xA0), {}, 1000});
+    writer.add({id(0x20), id(0xA0), {}, 1001});
+    writer.add({id(0x30), id(0xA0), {}, 1002});
+    writer.add({id(0x40), id(0xA1), {id(0x10), id(0x20), id(0x30)}, 1003});
+    // Родителя 0x99 в наборе нет: коммит 0x50 и его потомок 0x60 отбрасываются
+    writer.add({id(0x50), id(0xA2), {id(0x99)}, 1004});
+    writer.add({id(0x60), id(0xA2), {id(0x50)}, 1005});
+
+    std::string path = (std::filesystem::temp_directory_path() / "graphviz_octopus.graph").string();
+    BOOST_REQUIRE(writer.write(path));
+    CommitGraph graph;
+    BOOST_REQUIRE(graph.loadFile(path));
+    BOOST_CHECK_EQUAL(graph.commitCount(), 4u);
+
+    CommitGraphWriter::ObjectId merge = id(0x40);
+    int64_t pos = graph.findCommit(merge.data());
+    BOOST_REQUIRE(pos >= 0);
+    BOOST_CHECK_EQUAL(graph.generationAt(pos), 2u);
+    BOOST_CHECK_EQUAL(graph.commitTimeAt(pos), 1003u);
+    std::vector<uint64_t> parents;
+    graph.parentsAt(pos, parents);
+    BOOST_CHECK((parents == std::vector<uint64_t>{0, 1, 2}));
+    std::filesystem::remove(path);
 }
 
+BOOST_AUTO_TEST_CASE(TestCommitGraphWriter_ParseCommit) {
+    std::string text = "tree 8773564139ebfcff054bfcfdca1e09c3e536ac03\n"
+                       "parent f3ca7f8ee18de0ab94d66fc5c19afdc78b0eb749\n"
+                       "author dev <dev@example.com> 1700000700 +0300\n"
+                       "committer dev <dev@example.com> 1700000800 +0000\n"
+                       "\nparent 0000000000000000000000000000000000000000\n";
+    CommitGraphWriter::Commit commit;
+    BOOST_REQUIRE(CommitGraphWriter::parseCommit(std::vector<uint8_t>(text.begin(), text.end()), commit));
+    BOOST_CHECK_EQUAL(commit.time, 1700000800u);
+    BOOST_REQUIRE_EQUAL(commit.parents.size(), 1u);
+    BOOST_CHECK_EQUAL(GitIdxParser::bytesToHex(commit.parents[0].data(), 20), "f3ca7f8ee18de0ab94d66fc5c19afdc78b0eb749");
+    BOOST_CHECK_EQUAL(GitIdxParser::bytesToHex(commit.tree.data(), 20), "8773564139ebfcff054bfcfdca1e09c3e536ac03");
+}
+
+BOOST_AUTO_TEST_CASE(TestCommitHeader_MergeWithSignature) {
+    std::string text = "tree 8773564139ebfcff054bfcfdca1e09c3e536ac03\n"
+                       "parent f3ca7f8ee18de0ab94d66fc5c19afdc78b0eb749\n"
+                       "parent bcaeabf03b7aeb7c33d6fb1ff3b0c08d82d8ac82\n"
+                       "parent 22ae6f04f1f3d73122f1e288419ff12bbe28bde8\n"
+                       "author Иван <ivan@example.com> 1700000700 +0300\n"
+                       "committer dev <dev@example.com> 1700000800 -0130\n"
+                       "gpgsig -----BEGIN PGP SIGNATURE-----\n"
+                       " parent 0000000000000000000000000000000000000000\n"
+                       " -----END PGP SIGNATURE-----\n"
+                       "\nMerge 1234567890\n";
+    CommitHeader header;
+    BOOST_REQUIRE(CommitHeader::parse(text, header));
+    BOOST_CHECK_EQUAL(header.tree, "8773564139ebfcff054bfcfdca1e09c3e536ac03");
+    BOOST_REQUIRE_EQUAL(header.parentCount(), 3u);
+    BOOST_CHECK_EQUAL(header.parent(0), "f3ca7f8ee18de0ab94d66fc5c19afdc78b0eb749");
+    BOOST_CHECK_EQUAL(header.parent(2), "22ae6f04f1f3d73122f1e288419ff12bbe28bde8");
+    BOOST_CHECK_EQUAL(header.author.identity, "Иван <ivan@example.com>");
+    BOOST_CHECK_EQUAL(header.author.time, 1700000700);
+    BOOST_CHECK_EQUAL(header.author.timezone, 180);
+    BOOST_CHECK_EQUAL(header.committer.time, 1700000800);
+    BOOST_CHECK_EQUAL(header.committer.timezone, -90);
+    BOOST_CHECK_EQUAL(header.message, "Merge 1234567890\n");
+    // Все поля — окна в исходный текст
+    BOOST_CHECK(header.tree.data() >= text.data() && header.tree.data() < text.data() + text.size());
+}
+
+BOOST_AUTO_TEST_CASE(TestCommitHeader_RootAndInvalid) {
+    std::string root = "tree 8773564139ebfcff054bfcfdca1e09c3e536ac03\n"
+                       "author dev <dev@example.com> 1700000100 +0000\n"
+                       "committer dev <dev@example.com> 1700000100 +0000\n\nc1\n";
+    CommitHeader header;
+    BOOST_REQUIRE(CommitHeader::parse(root, header));
+    BOOST_CHECK_EQUAL(header.parentCount(), 0u);
 
+    BOOST_CHECK(!CommitHeader::parse("Commit 1234567890", header));
+    BOOST_CHECK(!CommitHeader::parse("tree 8773564139ebfcff054bfcfdca1e09c3e536ac03\n"
+                                     "committer dev <dev@example.com> noon +0000\n", header));
+}
 
+BOOST_AUTO_TEST_CASE(TestParseCommitObject_RootHasNoParent) {
+    PackSet packs(mockPacksDir);
+    unsigned char sha1[20];
+    GitIdxParser::hexToBytes(rootCommitSha, sha1);
+    GitObjectType type;
+    std::vector<uint8_t> content;
+    BOOST_REQUIRE(packs.readObject(sha1, type, content));
 
+    CommitRecord record;
+    BOOST_REQUIRE(GitIdxParser::parseCommitObject(sha1, type, content, 0, record));
+    BOOST_CHECK(record.parents.empty());
+    BOOST_CHECK_EQUAL(record.time, 1700000100);
+    BOOST_CHECK(!GitIdxParser::parseCommitObject(sha1, type, content, 1700000101, record));
+}
 
+// mock_refs: HEAD -> refs/heads/main (c8, отдельный файл новее packed-refs),
+// origin/main -> c4, тег v1 снят строкой ^ до c2
+static std::string hexOf(const HistoryWalk::ObjectId& id) {
+    return GitIdxParser::bytesToHex(id.data(), 20);
+}
 
+BOOST_AUTO_TEST_CASE(TestHistoryWalk_ReadRefs) {
+    std::vector<HistoryWalk::ObjectId> tips = HistoryWalk::readRefs("mock_refs");
+    std::vector<std::string> hex;
+    for (const HistoryWalk::ObjectId& id : tips) {
+        hex.push_back(hexOf(id));
+    }
+    std::vector<std::string> expected = {"32e14f3a5dcc589409f81687bb1868636f7a3380",
+                                         "a60e86b0a6548459222a81bbba95386640eed89c",
+                                         "b5834eb3c1b27f84502026e762e54fd1acfaa5ba"};
+    BOOST_CHECK(hex == expected);
+}
 
+BOOST_AUTO_TEST_CASE(TestHistoryWalk_StopsAtDateCutoff) {
+    PackSet packs(mockPacksDir);
+    std::vector<HistoryWalk::ObjectId> tips = HistoryWalk::readRefs("mock_refs");
 
+    CommitGraph graph;
+    BOOST_REQUIRE(graph.load("mock_graph_split"));
+    const CommitGraph* graphs[] = {nullptr, &graph};
+    for (const CommitGraph* commitGraph : graphs) {
+        HistoryWalk walk({&packs}, commitGraph);
+        size_t visited = 0;
+        std::vector<CommitRecord> window = walk.collectCommits(tips, 1700000500, &visited);
 
+        // c5..c8; c4 прочитан, но уже старше границы, до c1 обход не доходит
+        BOOST_REQUIRE_EQUAL(window.size(), 4u);
+        for (const CommitRecord& commit : window) {
+            BOOST_CHECK(commit.time >= 1700000500);
+            BOOST_CHECK_EQUAL(commit.parents.size(), 1u);
+        }
+        BOOST_CHECK_LT(visited, 8u);
 
+        // Без границы результат совпадает с перебором всех объектов
+        std::vector<CommitRecord> all = walk.collectCommits(tips, 0);
+        std::vector<CommitRecord> scanned = packs.collectCommits(0);
+        BOOST_REQUIRE_EQUAL(all.size(), scanned.size());
+        for (size_t i = 0; i < all.size(); i++) {
+            BOOST_CHECK_EQUAL(std::memcmp(all[i].id, scanned[i].id, 20), 0);
+            BOOST_CHECK(all[i].parents == scanned[i].parents);
+        }
+    }
+}
+
+// Коммит для тестов раскладки: id из одного повторённого байта
+static CommitRecord makeCommit(unsigned char id, int time, std::vector<unsigned char> parents) {
+    CommitRecord commit;
+    std::memset(commit.id, id, 20);
+    commit.time = time;
+    for (unsigned char parent : parents) {
+        unsigned char bytes[20];
+        std::memset(bytes, parent, 20);
+        commit.parents.push_back(GitIdxParser::bytesToHex(bytes, 20));
+    }
+    return commit;
+}
+
+BOOST_AUTO_TEST_CASE(TestGraphRenderer_LayoutLanes) {
+    // 1 <- 2 <- 4 (слияние 3), 1 <- 3; у 1 родитель 9 вне выборки
+    std::vector<CommitRecord> commits = {makeCommit(1, 100, {9}), makeCommit(2, 200, {1}),
+                                         makeCommit(3, 300, {1}), makeCommit(4, 400, {2, 3})};
+    GraphLayout layout = GraphRenderer::layout(commits);
+    BOOST_REQUIRE_EQUAL(layout.rows.size(), 4u);
+    BOOST_CHECK_EQUAL(layout.width, 2u);
+
+    // Сверху самый новый, корень внизу; цепочка первых родителей в колонке 0
+    std::vector<size_t> order, columns;
+    for (const GraphLayout::Node& node : layout.rows) {
+        order.push_back(node.commit);
+        columns.push_back(node.column);
+    }
+    BOOST_CHECK((order == std::vector<size_t>{3, 2, 1, 0}));
+    BOOST_CHECK((columns == std::vector<size_t>{0, 1, 0, 0}));
+
+    BOOST_REQUIRE_EQUAL(layout.edges.size(), 5u);
+    size_t outside = 0;
+    for (const GraphLayout::Edge& edge : layout.edges) {
+        outside += edge.toRow < 0;
+        BOOST_CHECK(edge.toRow < 0 || edge.toRow > static_cast<int64_t>(edge.fromRow));
+    }
+    BOOST_CHECK_EQUAL(outside, 1u);
+}
 
+BOOST_AUTO_TEST_CASE(TestGraphRenderer_WritesSvgAndPng) {
+    PackSet packs(mockPacksDir);
+    std::vector<CommitRecord> commits = packs.collectCommits(0);
+    GraphLayout layout = GraphRenderer::layout(commits);
+    BOOST_CHECK_EQUAL(layout.width, 1u);
 
+    std::filesystem::path dir = std::filesystem::temp_directory_path();
+    std::string svgPath = (dir / "graphviz_test.svg").string();
+    GraphRenderer::writeSvg(layout, commits, svgPath);
+    std::ifstream svgFile(svgPath);
+    std::string svg((std::istreambuf_iterator<char>(svgFile)), std::istreambuf_iterator<char>());
+    size_t circles = 0;
+    for (size_t pos = svg.find("<circle"); pos != std::string::npos; pos = svg.find("<circle", pos + 1)) {
+        circles++;
+    }
+    BOOST_CHECK_EQUAL(circles, commits.size());
+    BOOST_CHECK(svg.find(uncoveredCommitSha) != std::string::npos);
 
+    // PNG: подпись, IHDR и распакованные строки нужной длины
+    std::string pngPath = (dir / "graphviz_test.png").string();
+    GraphRenderer::writePng(layout, commits, pngPath);
+    std::ifstream pngFile(pngPath, std::ios::binary);
+    std::vector<unsigned char> png((std::istreambuf_iterator<char>(pngFile)), std::istreambuf_iterator<char>());
+    BOOST_REQUIRE_GT(png.size(), 33u);
+    BOOST_CHECK_EQUAL(std::memcmp(png.data(), "\x89PNG\r\n\x1a\n", 8), 0);
+    BOOST_CHECK_EQUAL(std::memcmp(png.data() + 12, "IHDR", 4), 0);
+    uint32_t width = (png[16] << 24) | (png[17] << 16) | (png[18] << 8) | png[19];
+    uint32_t height = (png[20] << 24) | (png[21] << 16) | (png[22] << 8) | png[23];
+    BOOST_CHECK_EQUAL(height, commits.size() * 10);
 
+    std::vector<unsigned char> idat;
+    for (size_t pos = 8; pos + 12 <= png.size();) {
+        uint32_t length = (png[pos] << 24) | (png[pos + 1] << 16) | (png[pos + 2] << 8) | png[pos + 3];
+        if (std::memcmp(png.data() + pos + 4, "IDAT", 4) == 0) {
+            idat.insert(idat.end(), png.begin() + pos + 8, png.begin() + pos + 8 + length);
+        }
+        pos += 12 + length;
+    }
+    uLongf rawSize = static_cast<uLongf>(height) * (1 + width * 3);
+    std::vector<unsigned char> raw(rawSize);
+    BOOST_REQUIRE_EQUAL(uncompress(raw.data(), &rawSize, idat.data(), idat.size()), Z_OK);
+    BOOST_CHECK_EQUAL(rawSize, static_cast<uLongf>(height) * (1 + width * 3));
 
+    std::filesystem::remove(svgPath);
+    std::filesystem::remove(pngPath);
+}
+
+// mock_plantuml.sh отвечает по протоколу -pipe без Java
+static const std::vector<std::string> mockPlantUml = {"sh", "mock_plantuml.sh", "-pipe", "-tpng"};
+
+BOOST_AUTO_TEST_CASE(TestPlantUmlPipe_RendersDocumentsInOrder) {
+    PlantUmlPipe pipe(mockPlantUml);
+    std::vector<std::string> documents = {"@startuml\na -> b\n@enduml\n", "@startuml\n@enduml",
+                                          "@startuml\na -> b\nb -> c\n@enduml\n"};
+    std::vector<std::string> images;
+    pipe.render(documents, [&](size_t i, const std::vector<uint8_t>& image) {
+        BOOST_CHECK_EQUAL(i, images.size());
+        images.emplace_back(image.begin(), image.end());
+    });
+    BOOST_CHECK((images == std::vector<std::string>{"image 1 3\n", "image 2 2\n", "image 3 4\n"}));
+
+    // Тот же процесс принимает следующую порцию
+    pipe.render({documents[0]}, [&](size_t, const std::vector<uint8_t>& image) {
+        BOOST_CHECK_EQUAL(std::string(image.begin(), image.end()), "image 4 3\n");
+    });
+}
+
+BOOST_AUTO_TEST_CASE(TestPlantUmlPipe_LargeOutputsDoNotDeadlock) {
+    // Ответы больше буфера канала, документов больше, чем допускается в работе
+    PlantUmlPipe pipe(mockPlantUml, 2);
+    std::vector<std::string> documents(40, "@startuml\n' size 200000\n@enduml\n");
+    size_t rendered = 0;
+    pipe.render(documents, [&](size_t i, const std::vector<uint8_t>& image) {
+        std::string expected = "image " + std::to_string(i + 1) + " 3\n";
+        BOOST_REQUIRE_EQUAL(image.size(), expected.size() + 200001);
+        BOOST_CHECK(std::equal(expected.begin(), expected.end(), image.begin()));
+        rendered++;
+    });
+    BOOST_CHECK_EQUAL(rendered, documents.size());
+}
+
+BOOST_AUTO_TEST_CASE(TestPlantUmlPipe_RenderFilesAndFailures) {
+    std::filesystem::path puml = std::filesystem::temp_directory_path() / "graphviz_pipe_test.puml";
+    std::ofstream(puml.string()) << "@startuml\na -> b\n@enduml\n";
+    PlantUmlPipe pipe(mockPlantUml);
+    std::vector<std::string> outputs = pipe.renderFiles({puml.string()});
+    BOOST_REQUIRE_EQUAL(outputs.size(), 1u);
+    BOOST_CHECK_EQUAL(std::filesystem::path(outputs[0]).extension(), ".png");
+    BOOST_CHECK_EQUAL(std::filesystem::file_size(outputs[0]), std::string("image 1 3\n").size());
+    std::filesystem::remove(puml);
+    std::filesystem::remove(outputs[0]);
+
+    PlantUmlPipe missing({"/nonexistent/plantuml"});
+    BOOST_CHECK_THROW(missing.render({"@startuml\n@enduml\n"}, [](size_t, const std::vector<uint8_t>&) {}),
+                      std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(TestPlantUmlPipe_HungProcessIsKilled) {
+    // Процесс не завершается по концу stdin и не реагирует на SIGTERM
+    auto start = std::chrono::steady_clock::now();
+    {
+        PlantUmlPipe hung({"sh", "-c", "trap '' TERM; exec sleep 600"});
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    BOOST_CHECK_LT(seconds, 15.0);
+}
+
+static bool sameCommits(const std::vector<CommitRecord>& a, const std::vector<CommitRecord>& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); i++) {
+        if (std::memcmp(a[i].id, b[i].id, 20) != 0 || a[i].time != b[i].time || a[i].parents != b[i].parents) {
+            return false;
+        }
+    }
+    return true;
+}
 
+BOOST_AUTO_TEST_CASE(TestCommitCache_RerunSkipsKnownPacks) {
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "graphviz_result_cache_test";
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    // Запись pack файла, которого уже нет, как после git gc
+    std::ofstream((dir / "commits-0000000000000000000000000000000000000000.cache").string());
+    BOOST_REQUIRE(std::filesystem::exists(dir / "commits-0000000000000000000000000000000000000000.cache"));
+
+    PackSet packs(mockPacksDir);
+    CommitCache cache(dir.string());
+    ExtractOptions options;
+    options.resultCache = &cache;
+    std::vector<CommitRecord> expected = packs.collectCommits(1700000400);
+    BOOST_CHECK(sameCommits(packs.collectCommits(1700000400, options), expected));
+    BOOST_CHECK_EQUAL(cache.packStats.misses, 3u);
+    BOOST_CHECK(!std::filesystem::exists(dir / "commits-0000000000000000000000000000000000000000.cache"));
+
+    // Повторный запуск берёт всё из кэша, а граница date применяется к записанным коммитам
+    PackSet reopened(mockPacksDir);
+    BOOST_CHECK(sameCommits(reopened.collectCommits(0, options), packs.collectCommits(0)));
+    BOOST_CHECK_EQUAL(cache.packStats.hits, 3u);
+    BOOST_CHECK_EQUAL(reopened.openedPackCount(), 0u);
+
+    // Испорченная запись разбирается заново
+    const GitIdxParser* index = packs.packIndex(0);
+    std::filesystem::path entry = dir / ("commits-" + GitIdxParser::bytesToHex(index->packChecksum(), 20) + ".cache");
+    std::filesystem::resize_file(entry, std::filesystem::file_size(entry) - 1);
+    std::vector<CommitRecord> part;
+    BOOST_CHECK(!cache.loadPack(index->packChecksum(), part));
+    BOOST_CHECK(sameCommits(PackSet(mockPacksDir).collectCommits(1700000400, options), expected));
+    BOOST_CHECK(cache.loadPack(index->packChecksum(), part));
+    std::filesystem::remove_all(dir);
+}
+
+BOOST_AUTO_TEST_CASE(TestCommitCache_PartlyDecodedPackNotStored) {
+    std::filesystem::path packDir = std::filesystem::temp_directory_path() / "graphviz_corrupt_result_packs";
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "graphviz_corrupt_result_cache";
+    std::filesystem::remove_all(packDir);
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(packDir);
+    std::filesystem::create_directories(dir);
+    GitIdxParser idx;
+    BOOST_REQUIRE(idx.mapFile("mock_delta.idx"));
+    std::filesystem::copy_file("mock_delta.idx", packDir / "pack-corrupt.idx");
+    writeCorruptDeltaPack(idx, (packDir / "pack-corrupt.pack").string());
+
+    // Пропущенный коммит не записывается в кэш: следующий запуск разбирает pack заново
+    CommitCache cache(dir.string());
+    ExtractOptions options;
+    options.resultCache = &cache;
+    std::vector<CommitRecord> first = PackSet(packDir.string()).collectCommits(0, options);
+    BOOST_CHECK_EQUAL(first.size(), idx.collectCommits(mockDeltaPackPath, 0).size() - 1);
+    std::vector<CommitRecord> part;
+    BOOST_CHECK(!cache.loadPack(idx.packChecksum(), part));
+    BOOST_CHECK(sameCommits(PackSet(packDir.string()).collectCommits(0, options), first));
+    BOOST_CHECK_EQUAL(cache.packStats.hits, 0u);
+    BOOST_CHECK_EQUAL(cache.packStats.misses, 2u);
+    std::filesystem::remove_all(packDir);
+    std::filesystem::remove_all(dir);
+}
+
+BOOST_AUTO_TEST_CASE(TestCommitCache_RerunSkipsKnownLooseObjects) {
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "graphviz_loose_cache_test";
+    std::filesystem::remove_all(dir);
+    LooseObjectStore loose(mockLooseDir);
+    CommitCache cache(dir.string());
+    ExtractOptions options;
+    options.resultCache = &cache;
+
+    BOOST_CHECK(sameCommits(loose.collectCommits(0, options), loose.collectCommits(0)));
+    BOOST_CHECK_EQUAL(cache.looseStats.misses, 7u);
+    BOOST_CHECK(sameCommits(loose.collectCommits(2000000000, options), loose.collectCommits(2000000000)));
+    BOOST_CHECK_EQUAL(cache.looseStats.misses, 7u);
+    BOOST_CHECK_EQUAL(cache.looseStats.hits, 7u);
+    std::filesystem::remove_all(dir);
+}
+
+BOOST_AUTO_TEST_CASE(TestPackReverseIndex_RevFileMatchesBuiltIndex) {
+    // .rev записан git index-pack --rev-index
+    std::string base = mockPacksDir + "/pack-0099adad11264af1ca68f46fa012b2655dd8ecaf";
+    GitIdxParser index;
+    BOOST_REQUIRE(index.mapFile(base + ".idx"));
+    uint64_t packSize = std::filesystem::file_size(base + ".pack");
+
+    PackReverseIndex loaded, built;
+    BOOST_REQUIRE(loaded.load(base + ".rev", index, packSize));
+    built.build(index, packSize);
+    BOOST_REQUIRE_EQUAL(loaded.objectCount(), index.objectCount());
+    uint64_t total = 0;
+    for (size_t r = 0; r < loaded.objectCount(); r++) {
+        BOOST_CHECK_EQUAL(loaded.indexPositionAt(r), built.indexPositionAt(r));
+        BOOST_CHECK_EQUAL(loaded.offsetAt(r), index.offsetAt(loaded.indexPositionAt(r)));
+        BOOST_CHECK_EQUAL(loaded.endOf(loaded.offsetAt(r)), loaded.offsetAt(r) + loaded.diskSizeAt(r));
+        total += loaded.diskSizeAt(r);
+    }
+    // Объекты занимают всё между заголовком и концевиком pack файла
+    BOOST_CHECK_EQUAL(total, packSize - 12 - 20);
+
+    // .rev того же размера, но с контрольной суммой другого pack файла
+    std::ifstream input(base + ".rev", std::ios::binary);
+    std::vector<char> rev((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    BOOST_REQUIRE_EQUAL(rev.size(), 12 + index.objectCount() * 4 + 40);
+    rev[12 + index.objectCount() * 4] ^= 0x01;
+    std::filesystem::path foreign = std::filesystem::temp_directory_path() / "graphviz_foreign.rev";
+    std::ofstream(foreign.string(), std::ios::binary).write(rev.data(), rev.size());
+
+    // Сообщение об ошибке перехватывается: по нему видно, какая проверка сработала
+    std::ostringstream errors;
+    std::streambuf* previous = std::cerr.rdbuf(errors.rdbuf());
+    PackReverseIndex mismatched;
+    bool mismatchedLoaded = mismatched.load(foreign.string(), index, packSize);
+    std::cerr.rdbuf(previous);
+    BOOST_CHECK(!mismatchedLoaded);
+    BOOST_CHECK(errors.str().find("другому pack файлу") != std::string::npos);
+    std::filesystem::remove(foreign);
+}
+
+BOOST_AUTO_TEST_CASE(TestPackReverseIndex_BoundedInflateAndSizes) {
+    PackSet packs(mockPacksDir);
+    for (size_t p = 0; p < packs.packCount(); p++) {
+        const GitPackParser* parser = packs.packParser(p);
+        BOOST_REQUIRE(parser && parser->reverseIndexOf());
+        const GitIdxParser* index = packs.packIndex(p);
+        // Каждый объект распаковывается в пределах своих байт
+        for (size_t i = 0; i < index->objectCount(); i++) {
+            BOOST_CHECK_NO_THROW(parser->getObjectContent(index->offsetAt(i)));
+        }
+        GitPackParser::SizeStats stats = parser->sizeStatistics();
+        uint64_t objects = 0;
+        for (uint64_t count : stats.objects) {
+            objects += count;
+        }
+        BOOST_CHECK_EQUAL(objects, index->objectCount());
+    }
+    BOOST_CHECK_EQUAL(packs.sizeStatistics().objects[static_cast<int>(GitObjectType::COMMIT)], 8u);
+}
+
+BOOST_AUTO_TEST_CASE(TestGetObjectContent_ReusesCallerBuffer) {
+    GitIdxParser idx;
+    BOOST_REQUIRE(idx.mapFile("mock_delta.idx"));
+    GitPackParser parser(mockDeltaPackPath);
+    parser.setIndex(&idx);
+    parser.loadReverseIndex();
+    GitPackParser fresh(mockDeltaPackPath);
+    fresh.deltaBaseCache().setMemoryLimit(0);
+
+    // Один буфер на все объекты: результат тот же, что у копирующего вызова.
+    // После первого прохода ёмкости хватает на любой объект, и буфер остаётся
+    // тем же — с кэшем баз, без него и со сворачиванием дельт
+    std::vector<uint8_t> content;
+    for (int pass = 0; pass < 4; pass++) {
+        if (pass == 2) {
+            parser.deltaBaseCache().clear();
+        }
+        const uint8_t* data = content.data();
+        size_t capacity = content.capacity();
+        for (size_t i = 0; i < idx.objectCount(); i++) {
+            GitObjectType type = parser.getObjectContent(idx.offsetAt(i), content, pass == 3);
+            auto expected = fresh.getObjectContent(idx.offsetAt(i));
+            BOOST_CHECK(type == expected.first);
+            BOOST_CHECK(content == expected.second);
+            if (pass > 0) {
+                BOOST_CHECK(content.data() == data);
+                BOOST_CHECK_EQUAL(content.capacity(), capacity);
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(TestDecompressor_AllBackendsAgree) {
+    std::string text;
+    for (int i = 0; i < 5000; i++) {
+        text += "line " + std::to_string(i * 7919 % 1000) + "\n";
+    }
+    std::vector<uint8_t> compressed(compressBound(text.size()));
+    uLongf compressedSize = compressed.size();
+    BOOST_REQUIRE_EQUAL(compress(compressed.data(), &compressedSize, reinterpret_cast<const Bytef*>(text.data()),
+                                 text.size()), Z_OK);
+
+    BOOST_CHECK(Decompressor::isAvailable(Decompressor::Backend::ZLIB));
+    for (Decompressor::Backend backend : Decompressor::availableBackends()) {
+        BOOST_TEST_CONTEXT(Decompressor::backendName(backend)) {
+            Decompressor& decompressor = Decompressor::forThread(backend);
+            BOOST_CHECK(decompressor.backend() == backend);
+            std::vector<uint8_t> output(text.size());
+            // Дважды подряд: состояние распаковщика сбрасывается между объектами
+            for (int pass = 0; pass < 2; pass++) {
+                decompressor.inflate(compressed.data(), compressedSize, output.data(), output.size());
+                BOOST_CHECK(std::equal(output.begin(), output.end(), text.begin()));
+            }
+            // Заявленный размер не совпал или поток обрезан
+            BOOST_CHECK_THROW(decompressor.inflate(compressed.data(), compressedSize, output.data(), output.size() - 1),
+                              std::runtime_error);
+            std::vector<uint8_t> larger(text.size() + 1);
+            BOOST_CHECK_THROW(decompressor.inflate(compressed.data(), compressedSize, larger.data(), larger.size()),
+                              std::runtime_error);
+            BOOST_CHECK_THROW(decompressor.inflate(compressed.data(), compressedSize / 2, output.data(), output.size()),
+                              std::runtime_error);
+        }
+    }
+
+    // zlib читает поток порциями, когда граница сжатых данных неизвестна
+    Decompressor& zlib = Decompressor::forThread(Decompressor::Backend::ZLIB);
+    size_t pos = 0;
+    Decompressor::InputSource portions = [&](const uint8_t*& data) -> size_t {
+        size_t n = std::min<size_t>(7, compressedSize - pos);
+        data = compressed.data() + pos;
+        pos += n;
+        return n;
+    };
+    std::vector<uint8_t> streamed(text.size());
+    zlib.inflate(portions, streamed.data(), streamed.size());
+    BOOST_CHECK(std::equal(streamed.begin(), streamed.end(), text.begin()));
+    pos = 0;
+    uint8_t prefix[10];
+    BOOST_REQUIRE_EQUAL(zlib.inflatePrefix(portions, prefix, sizeof(prefix)), sizeof(prefix));
+    BOOST_CHECK(std::equal(prefix, prefix + sizeof(prefix), text.begin()));
+
+    Decompressor::Backend parsed;
+    BOOST_CHECK(Decompressor::parseBackend("libdeflate", parsed) && parsed == Decompressor::Backend::LIBDEFLATE);
+    BOOST_CHECK(!Decompressor::parseBackend("lz4", parsed));
+    BOOST_CHECK(Decompressor::parseBackend("zlib-ng", parsed) && parsed == Decompressor::Backend::ZLIB_NG);
+    for (Decompressor::Backend backend : {Decompressor::Backend::ZLIB_NG, Decompressor::Backend::LIBDEFLATE}) {
+        if (!Decompressor::isAvailable(backend)) {
+            BOOST_CHECK(!Decompressor::create(backend));
+            BOOST_CHECK_THROW(PackSet(mockPacksDir).setDecompressor(backend), std::runtime_error);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(TestDecompressor_BenchmarkCoversEveryObject) {
+    PackSet packs(mockPacksDir);
+    size_t objects = 0;
+    for (size_t p = 0; p < packs.packCount(); p++) {
+        objects += packs.packIndex(p)->objectCount();
+    }
+    for (Decompressor::Backend backend : Decompressor::availableBackends()) {
+        GitPackParser::InflateBenchmark result = packs.benchmarkInflate(backend);
+        BOOST_CHECK_EQUAL(result.objects, objects);
+        BOOST_CHECK(result.compressedBytes > 0 && result.inflatedBytes > 0);
+    }
+}
+
+// Дельта из размеров и команд; размеры меньше 128 занимают один байт
+static std::vector<uint8_t> makeDelta(uint8_t baseSize, uint8_t resultSize, std::vector<uint8_t> ops) {
+    ops.insert(ops.begin(), {baseSize, resultSize});
+    return ops;
+}
+
+BOOST_AUTO_TEST_CASE(TestDelta_AppliesCopyAndInsert) {
+    std::vector<uint8_t> base = {'h', 'e', 'l', 'l', 'o', ' ', 'w', 'o', 'r', 'l', 'd'};
+    // "world" из базы (смещение 6, длина 5), вставка ", ", затем "hello"
+    std::vector<uint8_t> delta = makeDelta(11, 12, {0x91, 6, 5, 2, ',', ' ', 0x90, 5});
+    std::vector<uint8_t> result(100, 'x');
+    Delta::apply(base, delta, result);
+    BOOST_CHECK_EQUAL(std::string(result.begin(), result.end()), "world, hello");
+
+    Delta::Header header;
+    BOOST_REQUIRE(Delta::parseHeader(delta.data(), delta.size(), header));
+    BOOST_CHECK_EQUAL(header.baseSize, 11u);
+    BOOST_CHECK_EQUAL(header.resultSize, 12u);
+    BOOST_CHECK_EQUAL(header.opsOffset, 2u);
+    BOOST_CHECK(!Delta::parseHeader(delta.data(), 1, header));
+}
+
+BOOST_AUTO_TEST_CASE(TestDelta_ZeroSizeCopiesWholeWindow) {
+    // Копирование без байт длины означает 0x10000 байт
+    std::vector<uint8_t> base(0x10001);
+    for (size_t i = 0; i < base.size(); i++) {
+        base[i] = static_cast<uint8_t>(i * 31);
+    }
+    std::vector<uint8_t> delta = {0x81, 0x80, 0x04, 0x80, 0x80, 0x04, 0x81, 1};
+    std::vector<uint8_t> result;
+    Delta::apply(base, delta, result);
+    BOOST_REQUIRE_EQUAL(result.size(), 0x10000u);
+    BOOST_CHECK(std::equal(result.begin(), result.end(), base.begin() + 1));
+}
+
+BOOST_AUTO_TEST_CASE(TestDelta_LongCopyFromTwoByteCommand) {
+    // 0xC0 0x03: только третий байт длины, копируется 0x30000 байт с начала базы.
+    // Команда в два байта пишет больше 0x10000 байт на байт дельты
+    std::vector<uint8_t> base(0x30000);
+    for (size_t i = 0; i < base.size(); i++) {
+        base[i] = static_cast<uint8_t>(i * 7);
+    }
+    std::vector<uint8_t> delta = {0x80, 0x80, 0x0C, 0x80, 0x80, 0x0C, 0xC0, 0x03};
+    std::vector<uint8_t> result;
+    Delta::apply(base, delta, result);
+    BOOST_CHECK(result == base);
+
+    Delta::Program program;
+    Delta::parse(delta.data(), delta.size(), program);
+    BOOST_REQUIRE_EQUAL(program.ops.size(), 1u);
+    BOOST_CHECK_EQUAL(program.ops[0].size, 0x30000u);
+}
+
+BOOST_AUTO_TEST_CASE(TestDelta_BenchmarkCoversEveryDelta) {
+    PackSet packs(mockPacksDir);
+    uint64_t deltas = 0;
+    uint64_t resultBytes = 0;
+    for (size_t p = 0; p < packs.packCount(); p++) {
+        const GitIdxParser* index = packs.packIndex(p);
+        const GitPackParser* parser = packs.packParser(p);
+        for (size_t i = 0; i < index->objectCount(); i++) {
+            PackedObject header = parser->readObjectHeader(index->offsetAt(i));
+            if (header.type == GitObjectType::OFS_DELTA || header.type == GitObjectType::REF_DELTA) {
+                deltas++;
+                resultBytes += parser->getObjectContent(index->offsetAt(i)).second.size();
+            }
+        }
+    }
+    BOOST_REQUIRE(deltas > 0);
+    GitPackParser::DeltaBenchmark result = packs.benchmarkDelta();
+    BOOST_CHECK_EQUAL(result.deltas, deltas);
+    BOOST_CHECK_EQUAL(result.resultBytes, resultBytes);
+    BOOST_CHECK(result.deltaBytes > 0);
+    BOOST_CHECK_EQUAL(result.corrupt, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(TestDelta_BenchmarkSkipsCorruptDelta) {
+    GitIdxParser idx;
+    BOOST_REQUIRE(idx.parseFile("mock_refdelta.idx"));
+    unsigned char sha1[20];
+    GitIdxParser::hexToBytes(deltaChainTipSha, sha1);
+    uint64_t offset = 0;
+    BOOST_REQUIRE(idx.findOffset(sha1, offset));
+
+    // База REF_DELTA заменяется на коммит: размер базы в дельте не совпадёт
+    GitPackParser original("mock_refdelta.pack");
+    original.setIndex(&idx);
+    const unsigned char* commit = nullptr;
+    for (size_t i = 0; i < idx.objectCount() && !commit; i++) {
+        if (original.readObjectHeader(idx.offsetAt(i)).type == GitObjectType::COMMIT) {
+            commit = idx.sha1At(i);
+        }
+    }
+    BOOST_REQUIRE(commit);
+    GitPackParser::DeltaBenchmark intact = original.benchmarkDelta();
+    PackedObject header = original.readObjectHeader(offset);
+    BOOST_REQUIRE(header.type == GitObjectType::REF_DELTA);
+    std::ifstream in("mock_refdelta.pack", std::ios::binary);
+    std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::copy(commit, commit + 20, bytes.begin() + (header.dataOffset - 20));
+    std::string corruptPack = (std::filesystem::temp_directory_path() / "graphviz_badbase.pack").string();
+    std::ofstream(corruptPack, std::ios::binary) << bytes;
+
+    {
+        GitPackParser parser(corruptPack);
+        parser.setIndex(&idx);
+        GitPackParser::DeltaBenchmark result;
+        BOOST_CHECK_NO_THROW(result = parser.benchmarkDelta());
+        BOOST_CHECK(result.corrupt > 0);
+        BOOST_CHECK_EQUAL(result.deltas + result.corrupt, intact.deltas);
+    }
+    std::filesystem::remove(corruptPack);
+}
+
+BOOST_AUTO_TEST_CASE(TestDelta_RejectsCorruptDeltas) {
+    std::vector<uint8_t> base = {'a', 'b', 'c', 'd'};
+    std::vector<uint8_t> result;
+    std::vector<std::vector<uint8_t>> corrupt = {
+        makeDelta(5, 4, {0x90, 4}),              // размер базы не совпал
+        makeDelta(4, 4, {0x91, 2, 4}),           // копирование за конец базы
+        makeDelta(4, 4, {0x91, 0xFF, 1}),        // смещение за концом базы
+        makeDelta(4, 4, {0x91, 0}),              // команда обрывается
+        makeDelta(4, 4, {3, 'x', 'y'}),          // вставка обрывается
+        makeDelta(4, 4, {0}),                    // зарезервированная команда
+        makeDelta(4, 2, {0x90, 4}),              // запись больше заявленного
+        makeDelta(4, 5, {0x90, 4}),              // запись меньше заявленного
+        {4, 0xFF, 0xFF, 0xFF, 0x7F, 0x90, 4},    // размер результата не по длине дельты
+    };
+    for (size_t i = 0; i < corrupt.size(); i++) {
+        BOOST_TEST_CONTEXT("дельта " << i) {
+            BOOST_CHECK_THROW(Delta::apply(base, corrupt[i], result), std::runtime_error);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(TestDelta_ComposeMatchesSequentialApply) {
+    std::vector<uint8_t> base = {'H', 'e', 'l', 'l', 'o', ' ', 'w', 'o', 'r', 'l', 'd'};
+    // "world, Hello" и обратно в "Hello, world!!": вторая дельта копирует и из
+    // вставки первой, и из её копий, а копии склеиваются с соседями
+    std::vector<uint8_t> lower = makeDelta(11, 12, {0x91, 6, 5, 2, ',', ' ', 0x90, 5});
+    std::vector<uint8_t> upper = makeDelta(12, 14, {0x91, 7, 5, 0x91, 5, 2, 0x90, 5, 2, '!', '!'});
+    std::vector<uint8_t> middle, expected;
+    Delta::apply(base, lower, middle);
+    Delta::apply(middle, upper, expected);
+
+    Delta::Program lowerProgram, upperProgram, composed;
+    Delta::parse(lower.data(), lower.size(), lowerProgram);
+    Delta::parse(upper.data(), upper.size(), upperProgram);
+    Delta::compose(lowerProgram, upperProgram, composed);
+    BOOST_CHECK_EQUAL(composed.baseSize, 11u);
+    BOOST_CHECK_EQUAL(composed.resultSize, 14u);
+
+    std::vector<uint8_t> result;
+    Delta::apply(base.data(), base.size(), composed, result);
+    BOOST_CHECK(result == expected);
+    BOOST_CHECK_EQUAL(std::string(result.begin(), result.end()), "Hello, world!!");
+}
+
+BOOST_AUTO_TEST_CASE(TestDelta_ComposeRejectsMismatchedChain) {
+    Delta::Program lower, upper, composed;
+    std::vector<uint8_t> first = makeDelta(4, 3, {0x90, 3});
+    std::vector<uint8_t> second = makeDelta(4, 4, {0x90, 4});
+    Delta::parse(first.data(), first.size(), lower);
+    Delta::parse(second.data(), second.size(), upper);
+    BOOST_CHECK_THROW(Delta::compose(lower, upper, composed), std::runtime_error);
+
+    std::vector<uint8_t> base = {'a', 'b', 'c'};
+    std::vector<uint8_t> result;
+    BOOST_CHECK_THROW(Delta::apply(base.data(), base.size(), lower, result), std::runtime_error);
+
+    std::vector<uint8_t> corrupt = makeDelta(4, 5, {0x90, 4});
+    BOOST_CHECK_THROW(Delta::parse(corrupt.data(), corrupt.size(), lower), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(TestGetObjectContent_ComposedChainsMatch) {
+    GitIdxParser idx;
+    BOOST_REQUIRE(idx.mapFile("mock_delta.idx"));
+    GitPackParser parser(mockDeltaPackPath);
+    GitPackParser composing(mockDeltaPackPath);
+
+    for (size_t i = 0; i < idx.objectCount(); i++) {
+        BOOST_TEST_CONTEXT("объект " << idx.hexAt(i)) {
+            auto [type, content] = parser.getObjectContent(idx.offsetAt(i));
+            auto [composedType, composedContent] = composing.getObjectContent(idx.offsetAt(i), true);
+            BOOST_CHECK(composedType == type);
+            BOOST_CHECK(composedContent == content);
+        }
+    }
+    BOOST_CHECK(composing.getObjectContent(deltaChainTip, true).second ==
+                parser.getObjectContent(deltaChainTip).second);
+}
+}